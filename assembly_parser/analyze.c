@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "analyze.h"
+
+static int max(int a,int b) {
+	return a>b?a:b;
+}
+
+/// earliest cycle the operand can be read
+static int ready(const PIPE *p,enum op_type t,int v) {
+	switch(t) {
+	case REG:  return p->reg_ready[v];
+	case ADDR: return p->mem_ready[v/4];
+	default:   return 0;
+	}
+}
+
+void pipe_issue(PIPE *p,const INST *i,int cc) {
+	int t=p->cycle,is_mem=i->op1_type==ADDR||i->op2_type==ADDR||i->op3_type==ADDR;
+
+	if(i->opcode==MOV) {
+		t=max(t,ready(p,i->op2_type,i->op2_value));
+	} else if(i->opcode!=EXIT) {
+		t=max(t,p->reg_ready[i->op3_type==NONE?i->op1_value:i->op2_value]);
+		t=max(t,i->op3_type==NONE?ready(p,i->op2_type,i->op2_value):ready(p,i->op3_type,i->op3_value));
+	}
+	/// a register is not written twice out of order
+	if(i->opcode!=EXIT&&i->op1_type==REG)
+		t=max(t,p->reg_ready[i->op1_value]);
+
+	if(t==p->cycle&&(p->issued==p->width||(is_mem&&p->mem_issued==PIPE_MEM_PORTS)))
+		++t;
+	if(t!=p->cycle) {
+		p->cycle=t;
+		p->issued=p->mem_issued=0;
+	}
+	++p->issued;
+	if(is_mem)
+		++p->mem_issued;
+
+	int done=t+cc;
+	if(i->opcode!=EXIT&&i->op1_type==REG)
+		p->reg_ready[i->op1_value]=done;
+	if(i->op1_type==ADDR)
+		p->mem_ready[i->op1_value/4]=done;
+	p->finish=max(p->finish,done);
+}
+
+int cache_access(CACHE *c,int addr) {
+	int n=addr/CACHE_LINE,set=n%CACHE_SETS,victim=0,w;
+	++c->tick;
+	for(w=0;w!=CACHE_WAYS;++w) {
+		if(c->line[set][w]==n) {
+			c->last[set][w]=c->tick;
+			++c->hits;
+			return CC_CACHE_HIT;
+		}
+		if(c->last[set][w]<c->last[set][victim])
+			victim=w;
+	}
+	c->line[set][victim]=n;
+	c->last[set][victim]=c->tick;
+	++c->misses;
+	return CC_CACHE_MISS;
+}
+
+void analyze_init(ANALYSIS *a,int width,int cache,int memsize) {
+	memset(a,0,sizeof(*a));
+	a->pipe.width=width;
+	if(width)
+		a->pipe.mem_ready=(int*)calloc(memsize,sizeof(int));
+	a->cache.on=cache;
+	memset(a->cache.line,-1,sizeof(a->cache.line));
+	a->memsize=memsize;
+	a->touched=(char*)calloc(memsize,1);
+	a->exit=-1;
+}
+
+/// count a read of the operand
+static void use(ANALYSIS *a,enum op_type t,int v) {
+	if(t==REG)
+		++a->reg_reads[v];
+	else if(t==ADDR)
+		++a->loads;
+}
+
+int analyze_inst(ANALYSIS *a,const INST *i) {
+	int cc=cycles(i),addr;
+	if(a->cache.on&&(addr=mem_addr(i))>=0)
+		cc+=cache_access(&a->cache,addr)-CC_MOV_MEM;
+	if(a->pipe.width)
+		pipe_issue(&a->pipe,i,cc);
+	++a->instructions;
+	a->cycles+=cc;
+	++a->count[i->opcode];
+	a->op_cycles[i->opcode]+=cc;
+
+	switch(i->opcode) {
+	case EXIT:
+		a->exit=i->op1_value;
+		break;
+	case MOV:
+		use(a,i->op2_type,i->op2_value);
+		break;
+	default:
+		/// 2-address arithmetic reads its destination, the 3-address form its two sources
+		if(i->op3_type==NONE) {
+			use(a,i->op1_type,i->op1_value);
+			use(a,i->op2_type,i->op2_value);
+		} else {
+			use(a,i->op2_type,i->op2_value);
+			use(a,i->op3_type,i->op3_value);
+		}
+	}
+	if(i->opcode!=EXIT&&i->op1_type==REG)
+		++a->reg_writes[i->op1_value];
+	else if(i->op1_type==ADDR)
+		++a->stores;
+
+	if((addr=mem_addr(i))>=0&&!a->touched[addr/4]) {
+		a->touched[addr/4]=1;
+		++a->words;
+	}
+	return cc;
+}
+
+void analyze_print(const ANALYSIS *a,FILE *out) {
+	int r,used=0;
+	enum code c;
+	fprintf(out,"Instructions %d\n",a->instructions);
+	fprintf(out,"Total clock cycles are %lld\n",a->cycles);
+	if(a->pipe.width)
+		fprintf(out,"Pipelined clock cycles are %d (issue width %d)\n",a->pipe.finish,a->pipe.width);
+	if(a->cache.on)
+		fprintf(out,"Cache hits %d, misses %d\n",a->cache.hits,a->cache.misses);
+	fprintf(out,"Memory loads %d, stores %d, %d of %d words\n",a->loads,a->stores,a->words,a->memsize);
+	for(r=0;r!=REG_COUNT;++r)
+		used+=a->reg_reads[r]||a->reg_writes[r];
+	fprintf(out,"Registers %d of %d\n",used,REG_COUNT);
+	for(r=0;r!=REG_COUNT;++r)
+		if(a->reg_reads[r]||a->reg_writes[r])
+			fprintf(out,"  r%-3d reads %-8d writes %d\n",r,a->reg_reads[r],a->reg_writes[r]);
+	fprintf(out,"Opcodes\n");
+	for(c=MOV;c<=XOR;++c)
+		if(a->count[c])
+			fprintf(out,"  %-5s %-8d %lldcc\n",opcodes[c].name,a->count[c],a->op_cycles[c]);
+	if(a->exit<0)
+		fprintf(out,"ending without EXIT\n");
+}
+
+void analyze_free(ANALYSIS *a) {
+	free(a->pipe.mem_ready);
+	free(a->touched);
+	a->pipe.mem_ready=NULL;
+	a->touched=NULL;
+}
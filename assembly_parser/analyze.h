@@ -0,0 +1,71 @@
+#ifndef __ANALYZE__
+#define __ANALYZE__
+
+#include <stdio.h>
+#include "machine.h"
+#include "inst.h"
+
+/// static cycle and resource analysis of a straight-line program
+/// programs have no branches, so the timing, the register use and the memory traffic
+/// do not depend on the values: feeding every decoded instruction to analyze_inst()
+/// gives the totals the simulator reports without executing anything
+/// the simulator charges its trace with it, the compiler links it to price candidate code
+
+/// in-order pipelined timing, enabled by a non-zero width
+/// every instruction takes its cycles() as latency, up to `width` issue per cycle
+/// and up to PIPE_MEM_PORTS of them may access memory
+typedef struct PIPE {
+	int width;      /// 0 when disabled
+	int cycle;      /// cycle the last instruction issued in
+	int issued;     /// instructions issued in `cycle`
+	int mem_issued; /// memory accesses issued in `cycle`
+	int finish;     /// cycle the last result is ready
+	int reg_ready[REG_COUNT];
+	int *mem_ready; /// `memsize` words
+} PIPE;
+
+/// data cache, see machine.h
+typedef struct CACHE {
+	int on;
+	int hits,misses;
+	int tick;                         /// accesses so far, for LRU
+	int line[CACHE_SETS][CACHE_WAYS]; /// line held by every way, -1 when empty
+	int last[CACHE_SETS][CACHE_WAYS]; /// tick of its last access
+} CACHE;
+
+typedef struct ANALYSIS {
+	PIPE pipe;
+	CACHE cache;
+	int memsize;                 /// words of memory
+	int instructions;
+	long long cycles;            /// charged one after the other, the simulator's total
+	int count[XOR+1];            /// instructions of every opcode
+	long long op_cycles[XOR+1];  /// and their cycles
+	int reg_reads[REG_COUNT];
+	int reg_writes[REG_COUNT];
+	int loads,stores;            /// memory words read and written
+	int words;                   /// distinct memory words accessed
+	char *touched;               /// `memsize` flags behind `words`
+	int exit;                    /// operand of the EXIT reached, -1 before
+} ANALYSIS;
+
+/// issue `i` in order, as soon as its operands are ready and a slot is free, its result takes `cc`
+void pipe_issue(PIPE *p,const INST *i,int cc);
+
+/// look `addr` up, load its line over the least recently used way on a miss
+/// return the cycles of the access
+int cache_access(CACHE *c,int addr);
+
+/// start an analysis, `width` 0 skips the pipelined timing, `cache` 0 the data cache
+void analyze_init(ANALYSIS *a,int width,int cache,int memsize);
+
+/// account for the next instruction of the program, addresses must be below `memsize` words
+/// return the cycles it is charged, cycles() unless the cache changed it
+int analyze_inst(ANALYSIS *a,const INST *i);
+
+/// write the report of `-a`: totals, memory traffic, registers and the opcode mix
+void analyze_print(const ANALYSIS *a,FILE *out);
+
+void analyze_free(ANALYSIS *a);
+
+#endif // __ANALYZE__
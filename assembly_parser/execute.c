@@ -0,0 +1,78 @@
+#include <limits.h>
+#include "machine.h"
+#include "execute.h"
+
+/// first handler of every opcode
+static const enum handler handler_base[]={H_MOV_R,H_ADD_R,H_SUB_R,H_MUL_R,H_DIV_R,H_EXIT,H_AND_R,H_OR_R,H_XOR_R};
+
+OP lower(const INST *i) {
+	OP op;
+	enum op_type rt=i->op3_type==NONE?i->op2_type:i->op3_type;
+	int rv=i->op3_type==NONE?i->op2_value:i->op3_value;
+	op.handler=handler_base[i->opcode]+rt;
+	op.d=i->op1_value;
+	op.a=i->op3_type==NONE?i->op1_value:i->op2_value;
+	op.b=rt==ADDR?rv/4:rv;
+	if(i->opcode==MOV&&i->op1_type==ADDR) {
+		op.handler=H_STORE;
+		op.d=i->op1_value/4;
+	}
+	if(i->opcode==EXIT)
+		op.handler=H_EXIT;
+	return op;
+}
+
+int execute(const OP *op,int *r,int *mem,char *fault) {
+	const OP *p=op;
+#define DIVIDE(x) \
+	if((x)==0) { r[p->d]=r[p->a]; fault[p-op]=FAULT_DIV_ZERO; } \
+	else if((x)==-1&&r[p->a]==INT_MIN) { r[p->d]=r[p->a]; fault[p-op]=FAULT_DIV_OVERFLOW; } \
+	else r[p->d]=r[p->a]/(x)
+#if defined(__GNUC__)
+	/// threaded dispatch, every handler jumps straight to the next one
+	static void *label[]={
+		&&L_H_MOV_R,&&L_H_MOV_C,&&L_H_MOV_M,&&L_H_STORE,
+		&&L_H_ADD_R,&&L_H_ADD_C,&&L_H_ADD_M,
+		&&L_H_SUB_R,&&L_H_SUB_C,&&L_H_SUB_M,
+		&&L_H_MUL_R,&&L_H_MUL_C,&&L_H_MUL_M,
+		&&L_H_DIV_R,&&L_H_DIV_C,&&L_H_DIV_M,
+		&&L_H_AND_R,&&L_H_AND_C,&&L_H_AND_M,
+		&&L_H_OR_R,&&L_H_OR_C,&&L_H_OR_M,
+		&&L_H_XOR_R,&&L_H_XOR_C,&&L_H_XOR_M,
+		&&L_H_EXIT
+	};
+#define CASE(h) L_##h:
+#define NEXT goto *label[(++p)->handler]
+	goto *label[p->handler];
+	{
+#else
+#define CASE(h) case h:
+#define NEXT break
+	for(;;++p)
+	switch(p->handler) {
+#endif
+#define ARITH(h,o) \
+	CASE(h##_R) r[p->d]=r[p->a] o r[p->b]; NEXT; \
+	CASE(h##_C) r[p->d]=r[p->a] o p->b; NEXT; \
+	CASE(h##_M) r[p->d]=r[p->a] o mem[p->b]; NEXT;
+	CASE(H_MOV_R) r[p->d]=r[p->b]; NEXT;
+	CASE(H_MOV_C) r[p->d]=p->b; NEXT;
+	CASE(H_MOV_M) r[p->d]=mem[p->b]; NEXT;
+	CASE(H_STORE) mem[p->d]=r[p->b]; NEXT;
+	ARITH(H_ADD,+)
+	ARITH(H_SUB,-)
+	ARITH(H_MUL,*)
+	ARITH(H_AND,&)
+	ARITH(H_OR,|)
+	ARITH(H_XOR,^)
+	CASE(H_DIV_R) DIVIDE(r[p->b]); NEXT;
+	CASE(H_DIV_C) DIVIDE(p->b); NEXT;
+	CASE(H_DIV_M) DIVIDE(mem[p->b]); NEXT;
+	CASE(H_EXIT) return p-op;
+	}
+#undef ARITH
+#undef NEXT
+#undef CASE
+#undef DIVIDE
+	return p-op;
+}
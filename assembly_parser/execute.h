@@ -0,0 +1,47 @@
+#ifndef __EXECUTE__
+#define __EXECUTE__
+
+#include "inst.h"
+
+/// the simulator's interpreter, shared with the compiler's in-process API
+/// nothing here has state of its own, so any number of programs may run at once
+
+/// handlers of the execute loop, one per opcode and kind of right operand
+/// the kinds follow enum op_type: register, constant, memory word
+enum handler {
+	H_MOV_R,H_MOV_C,H_MOV_M,H_STORE,
+	H_ADD_R,H_ADD_C,H_ADD_M,
+	H_SUB_R,H_SUB_C,H_SUB_M,
+	H_MUL_R,H_MUL_C,H_MUL_M,
+	H_DIV_R,H_DIV_C,H_DIV_M,
+	H_AND_R,H_AND_C,H_AND_M,
+	H_OR_R,H_OR_C,H_OR_M,
+	H_XOR_R,H_XOR_C,H_XOR_M,
+	H_EXIT
+};
+
+/// pre-decoded instruction, operands resolved to what the handler indexes
+/// memory operands hold word indices, both forms become rd = ra <op> b
+typedef struct OP {
+	enum handler handler;
+	int d; /// destination register, or word of a store
+	int a; /// left register
+	int b; /// right register, constant or word
+} OP;
+
+/// the handler and operands of a decoded instruction
+OP lower(const INST *i);
+
+/// what `fault` of an instruction holds after a run, a DIV that cannot divide keeps its dividend
+enum fault {
+	FAULT_NONE,
+	FAULT_DIV_ZERO,    /// by zero
+	FAULT_DIV_OVERFLOW /// INT_MIN by -1, the quotient does not fit
+};
+
+/// run `op` until its EXIT, the program ends with one
+/// a faulting DIV keeps the dividend and sets `fault` of the instruction, see enum fault
+/// returns the index of the EXIT
+int execute(const OP *op,int *r,int *mem,char *fault);
+
+#endif // __EXECUTE__
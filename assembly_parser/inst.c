@@ -0,0 +1,60 @@
+#include "machine.h"
+#include "inst.h"
+
+const OPCODE opcodes[XOR+1]={
+	[MOV]={"MOV",CC_MOV_REG},
+	[ADD]={"ADD",CC_ADD},
+	[SUB]={"SUB",CC_SUB},
+	[MUL]={"MUL",CC_MUL},
+	[DIV]={"DIV",CC_DIV},
+	[EXIT]={"EXIT",CC_EXIT},
+	[AND]={"AND",CC_AND},
+	[OR]={"OR",CC_OR},
+	[XOR]={"XOR",CC_XOR}
+};
+
+int cycles(const INST *i) {
+	enum op_type rhs=i->op3_type==NONE?i->op2_type:i->op3_type;
+	switch(i->opcode) {
+	case MOV:  return i->op1_type==ADDR||i->op2_type==ADDR?CC_MOV_MEM:opcodes[MOV].cycles;
+	case EXIT: return opcodes[EXIT].cycles;
+	default:   return opcodes[i->opcode].cycles+(rhs==CONST?CC_EXT_IMM:rhs==ADDR?CC_EXT_MEM:0);
+	}
+}
+
+int mem_addr(const INST *i) {
+	if(i->op1_type==ADDR) return i->op1_value;
+	if(i->op2_type==ADDR) return i->op2_value;
+	if(i->op3_type==ADDR) return i->op3_value;
+	return -1;
+}
+
+char *put_int(char *p,int v,int width) {
+	/// two digits per division
+	static const char pairs[]=
+		"0001020304050607080910111213141516171819"
+		"2021222324252627282930313233343536373839"
+		"4041424344454647484950515253545556575859"
+		"6061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+	char digits[12],*q=digits+sizeof(digits);
+	unsigned u=v<0?0u-(unsigned)v:(unsigned)v,k;
+	while(u>=100) {
+		k=u%100*2;
+		u/=100;
+		*--q=pairs[k+1];
+		*--q=pairs[k];
+	}
+	if(u>=10) {
+		*--q=pairs[u*2+1];
+		*--q=pairs[u*2];
+	} else
+		*--q=(char)('0'+u);
+	if(v<0)
+		*--q='-';
+	for(width-=(int)(digits+sizeof(digits)-q);q<digits+sizeof(digits);)
+		*p++=*q++;
+	while(width-->0)
+		*p++=' ';
+	return p;
+}
@@ -0,0 +1,61 @@
+#ifndef __INST__
+#define __INST__
+
+/// instruction of the simulated machine, shared by the simulator, the static analyzer,
+/// the binary formats and the compiler, whose IR uses the same opcodes (ir.h)
+
+enum code {
+	MOV,
+	ADD,
+	SUB,
+	MUL,
+	DIV,
+	EXIT,
+	AND,
+	OR,
+	XOR
+};
+
+enum op_type {
+	REG,
+	CONST,
+	ADDR,
+	NONE  /// no third operand
+};
+
+typedef struct INST {
+	enum code opcode;
+
+	enum op_type op1_type;
+	int op1_value;
+
+	enum op_type op2_type;
+	int op2_value;
+
+	/// set for the 3-address form `OP rd rs rt`, rd = rs <op> rt
+	enum op_type op3_type;
+	int op3_value;
+
+} INST;
+
+/// opcode table, indexed by enum code
+typedef struct OPCODE {
+	const char *name;
+	int cycles;       /// the register form, see cycles()
+} OPCODE;
+
+extern const OPCODE opcodes[XOR+1];
+
+/// cycles charged for the instruction without the cache, see machine.h
+/// a MOV from or to memory costs CC_MOV_MEM, an extension operand adds CC_EXT_IMM or CC_EXT_MEM
+int cycles(const INST *i);
+
+/// address `i` reads or writes, -1 when it does not access memory
+int mem_addr(const INST *i);
+
+/// append `v` at `p` left-justified in `width` columns, as printf("%-*d") without the parsing
+/// the compiler prints its instructions with it, the simulator its trace and batch rows
+/// returns the end of what was written, at most 11 characters or `width`
+char *put_int(char *p,int v,int width);
+
+#endif // __INST__
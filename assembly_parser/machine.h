@@ -0,0 +1,68 @@
+#ifndef __MACHINE__
+#define __MACHINE__
+
+/// parameters of the simulated machine, shared by the simulator and the compiler
+/// override with -DREG_COUNT=n / -DMEMSIZE=n, building both with the same values
+
+/// registers r0..r{REG_COUNT-1}, the result is read back from r0, r1, r2
+#ifndef REG_COUNT
+#define REG_COUNT 8
+#endif
+#if REG_COUNT < 3
+#error "REG_COUNT must be at least 3"
+#endif
+
+/// default words of memory, both take -m<words> to change it at run time
+#ifndef MEMSIZE
+#define MEMSIZE 64
+#endif
+
+/// cycles charged per instruction
+#define CC_MOV_REG 10  /// MOV between registers or from a constant
+#define CC_MOV_MEM 200 /// MOV from or to memory
+#define CC_ADD 10
+#define CC_SUB 10
+#define CC_MUL 30
+#define CC_DIV 50
+#define CC_AND 10
+#define CC_OR 10
+#define CC_XOR 10
+#define CC_EXIT 20
+
+/// ISA extensions: the right operand of ADD..XOR may be an immediate (`ADD r1 5`)
+/// or a memory word (`ADD r1 [8]`), charged these cycles on top of the register form
+#ifndef CC_EXT_IMM
+#define CC_EXT_IMM 0
+#endif
+#ifndef CC_EXT_MEM
+#define CC_EXT_MEM (CC_MOV_MEM - CC_MOV_REG)
+#endif
+
+/// pipelined timing (simulator -p<width>, compiler -p<width>): memory accesses issued per cycle
+#ifndef PIPE_MEM_PORTS
+#define PIPE_MEM_PORTS 1
+#endif
+
+/// data cache (simulator -c, compiler -c): a MOV from or to memory costs CC_CACHE_HIT or
+/// CC_CACHE_MISS instead of CC_MOV_MEM, a memory operand pays the same difference
+/// CACHE_SETS sets of CACHE_WAYS lines of CACHE_LINE bytes, LRU replacement, stores allocate
+#ifndef CACHE_LINE
+#define CACHE_LINE 16
+#endif
+#ifndef CACHE_WAYS
+#define CACHE_WAYS 2
+#endif
+#ifndef CACHE_SETS
+#define CACHE_SETS 4
+#endif
+#ifndef CC_CACHE_HIT
+#define CC_CACHE_HIT 20
+#endif
+#ifndef CC_CACHE_MISS
+#define CC_CACHE_MISS CC_MOV_MEM
+#endif
+#if CACHE_LINE < 4 || CACHE_LINE % 4 != 0
+#error "CACHE_LINE must be a multiple of 4"
+#endif
+
+#endif // __MACHINE__
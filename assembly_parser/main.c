@@ -2,6 +2,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <limits.h>
+#include "machine.h"
+#include "inst.h"
+#include "analyze.h"
+#include "object.h"
+#include "execute.h"
 
 /**
  * print error message.
@@ -13,89 +20,82 @@ printf("ERROR at '%s'\n => ", input); \
 printf(fmt, __VA_ARGS__); \
 printf("**********************************\n");
 
-enum code {
-	MOV,
-	ADD,
-	SUB,
-	MUL,
-	DIV,
-	EXIT,
-	AND,
-	OR,
-	XOR
-};
-
-enum op_type {
-	REG,
-	CONST,
-	ADDR
-};
-
-typedef struct INST {
-	enum code opcode;
+/// words of memory, MEMSIZE unless set by -m<words>
+/// addresses are checked once when decoded, so the execute loop indexes `mem` directly
+int memsize=MEMSIZE;
 
-	enum op_type op1_type;
-	int op1_value;
+char *put_str(char *p,const char *s) {
+	while(*s)
+		*p++=*s++;
+	return p;
+}
 
-	enum op_type op2_type;
-	int op2_value;
+/// append one operand column
+char *put_op(char *p,enum op_type t,int v) {
+	switch(t) {
+	case REG:   p=put_str(p," REG  : "); break;
+	case CONST: p=put_str(p," CONST: "); break;
+	case ADDR:  p=put_str(p," ADDR : "); break;
+	case NONE:  return p;
+	}
+	p=put_int(p,v,4);
+	return put_str(p," |");
+}
 
-} INST;
+/// write the trace row of `i`, formatted by hand and written with a single fwrite
+/// `cc` is what the instruction was charged, cycles() unless the cache changed it
+void print(const INST *i,int cc) {
+	char row[128],*p=row,*col;
+	p=put_str(p,opcodes[i->opcode].name);
+	for(col=row+5;p<col;)
+		*p++=' ';
+	*p++='|';
+	p=put_op(p,i->op1_type,i->op1_value);
+	if(i->opcode!=EXIT)
+		p=put_op(p,i->op2_type,i->op2_value);
+	else
+		p=put_str(p,"             |");
+	p=put_op(p,i->op3_type,i->op3_value);
+	*p++=' ';
+	col=p+7;
+	p=put_int(p,cc,0);
+	p=put_str(p,"cc");
+	while(p<col)
+		*p++=' ';
+	p=put_str(p,"|\n");
+	fwrite(row,1,p-row,stdout);
+}
 
-void print(const INST *i) {
-	switch (i->opcode) {
-	case MOV:  printf("MOV  |"); break;
-	case ADD:  printf("ADD  |"); break;
-	case SUB:  printf("SUB  |"); break;
-	case MUL:  printf("MUL  |"); break;
-	case DIV:  printf("DIV  |"); break;
-	case EXIT: printf("EXIT |"); break;
-	case AND:  printf("AND  |"); break;
-	case OR:   printf("OR   |"); break;
-	case XOR:  printf("XOR  |"); break;
-	}
+/// operand text of the line being decoded, not NUL-terminated
+typedef struct TOKEN {
+	const char *p;
+	int len;
+} TOKEN;
 
-	switch (i->op1_type) {
-	case REG:   printf(" REG  : %-4d |",i->op1_value); break;
-	case CONST: printf(" CONST: %-4d |",i->op1_value); break;
-	case ADDR:  printf(" ADDR : %-4d |",i->op1_value); break;
-	}
+/// whether `p[0..len)` are all digits
+int digits(const char *p,int len) {
+	int i;
+	for(i=0;i!=len;++i)
+		if(p[i]<'0'||p[i]>'9')
+			return 0;
+	return 1;
+}
 
-	if (i->opcode!=EXIT)
-		switch(i->op2_type) {
-		case REG:   printf(" REG  : %-4d |",i->op2_value); break;
-		case CONST: printf(" CONST: %-4d |",i->op2_value); break;
-		case ADDR:  printf(" ADDR : %-4d |",i->op2_value); break;
-		}
-	else
-		printf("             |");
-	switch(i->opcode) {
-	case MOV:
-		if(i->op1_type==REG&&(i->op2_type==REG||i->op2_type==CONST)) {
-			printf(" 10cc   |\n");
-			break;
-		}
-		if((i->op1_type==REG && i->op2_type==ADDR)||(i->op1_type==ADDR && i->op2_type==REG)) {
-			printf(" 200cc  |\n");
-			break;
-		}
-	case ADD:  printf(" 10cc   |\n"); break;
-	case SUB:  printf(" 10cc   |\n"); break;
-	case MUL:  printf(" 30cc   |\n"); break;
-	case DIV:  printf(" 50cc   |\n"); break;
-	case EXIT: printf(" 20cc   |\n"); break;
-	case AND:  printf(" 10cc   |\n"); break;
-	case OR:   printf(" 10cc   |\n"); break;
-	case XOR:  printf(" 10cc   |\n"); break;
-	}
+/// value of the decimal digits `p[0..len)`, wrapping like the machine's int
+int number(const char *p,int len) {
+	unsigned v=0;
+	int i;
+	for(i=0;i!=len;++i)
+		v=v*10+(unsigned)(p[i]-'0');
+	return (int)v;
 }
 
 /// check the op is register or not
-int readREG(const char *op,enum op_type *op_t,int *op_v) {
-	if(strlen(op)>=2&&op[0]=='r') {
-		if(op[1]>='0' && op[1]<='7') {
+int readREG(TOKEN op,enum op_type *op_t,int *op_v) {
+	if(op.len>=2&&op.p[0]=='r') {
+		if(digits(op.p+1,op.len-1)&&(op.p[1]!='0'||op.len==2)&&op.len<=10&&number(op.p+1,op.len-1)<REG_COUNT) {
 			*op_t=REG;
-			*op_v=op[1]-'0';
+			*op_v=number(op.p+1,op.len-1);
 			return 1;
 		}
 		return -1;
@@ -104,43 +104,46 @@ int readREG(const char *op,enum op_type *op_t,int *op_v) {
 }
 
 /// check the op is constant or not
-int readCONST(const char *op,enum op_type *op_t,int *op_v) {
-	int i;
-	for(i=(op[0]=='-'?1:0); i<strlen(op)&&isdigit(op[i]);++i);
-	if(i==strlen(op)) {
+int readCONST(TOKEN op,enum op_type *op_t,int *op_v) {
+	int neg=op.len>0&&op.p[0]=='-';
+	if(digits(op.p+neg,op.len-neg)) {
 		*op_t=CONST;
-		*op_v=atoi(op);
+		*op_v=neg?(int)(0u-(unsigned)number(op.p+1,op.len-1)):number(op.p,op.len);
 		return 1;
 	}
 	return 0;
 }
 
-int readADDR(const char *op,enum op_type *op_t,int *op_v) {
-	int i;
-
-	if(op[0]=='[' && op[strlen(op)-1]==']') {
-		for(i=1; i<strlen(op)-1&&isdigit(op[i]);++i);
-
-		if(i==strlen(op)-1) {
-			if(atoi(op+1)%4==0) {
+int readADDR(TOKEN op,enum op_type *op_t,int *op_v) {
+	if(op.len>=2&&op.p[0]=='['&&op.p[op.len-1]==']') {
+		if(digits(op.p+1,op.len-2)) {
+			/// more than 9 digits would not fit an int
+			if(op.len-2>9||number(op.p+1,op.len-2)/4>=memsize)
+				return -1;
+			if(number(op.p+1,op.len-2)%4==0) {
 				*op_t=ADDR;
-				*op_v=atoi(op+1);
+				*op_v=number(op.p+1,op.len-2);
 				return 1;
 			}
 			return -2;
 		}
-		return  -1;
+		return -1;
 	}
 	return 0;
 }
 
-int readOP(const char *input,char *op,enum op_type *op_t,int *op_v) {
+int readOP(const char *input,TOKEN op,enum op_type *op_t,int *op_v) {
 	/// check op type and read its value,
 	/// if success return 1, else return 0
 
+	if(op.len==0) {
+		error("%s\n","missing operand");
+		return 0;
+	}
+
 	switch(readREG(op,op_t,op_v)) {
 	case -1: /// REGISTER out of range
-		error("register out of range: '%s'\n",op);
+		error("register out of range: '%.*s'\n",op.len,op.p);
 		return 0;
 	case 1:  /// op is a REGISTER
 		return 1;
@@ -150,10 +153,10 @@ int readOP(const char *input,char *op,enum op_type *op_t,int *op_v) {
 
 	switch(readADDR(op,op_t,op_v)) {
 	case -1: /// ADDRESS out of range
-		error("address out of range: '%s'\n",op);
+		error("address out of range: '%.*s'\n",op.len,op.p);
 		return 0;
 	case -2: /// ADDRESS out of range
-		error("address must be multiple of 4 : '%s'\n",op);
+		error("address must be multiple of 4 : '%.*s'\n",op.len,op.p);
 		return 0;
 	case 1:  /// op is a ADDRESS
 		return 1;
@@ -163,7 +166,7 @@ int readOP(const char *input,char *op,enum op_type *op_t,int *op_v) {
 
 	switch(readCONST(op,op_t,op_v)) {
 	case 0:  /// op is not a CONSTANT
-		error("unknown operand type : '%s'\n",op);
+		error("unknown operand type : '%.*s'\n",op.len,op.p);
 		break;
 	case 1:  /// op is a CONSTANT
 		return 1;
@@ -171,73 +174,115 @@ int readOP(const char *input,char *op,enum op_type *op_t,int *op_v) {
 	return 0;
 }
 
+int max(int a,int b) {
+	return a>b?a:b;
+}
+
+/// read the whole of `f` into one NUL-terminated buffer
+char *readAll(FILE *f,size_t *size) {
+	size_t capacity=1<<16,got;
+	char *text=(char*)malloc(capacity+1);
+	*size=0;
+	while((got=fread(text+*size,1,capacity-*size,f))>0)
+		if((*size+=got)==capacity)
+			text=(char*)realloc(text,(capacity*=2)+1);
+	text[*size]='\0';
+	return text;
+}
+
+/// next operand of the line, separators are spaces, tabs and commas
+TOKEN nextToken(char **p) {
+	TOKEN t;
+	while(**p==' '||**p=='\t'||**p==','||**p=='\r')
+		++*p;
+	t.p=*p;
+	while(**p&&**p!=' '&&**p!='\t'&&**p!=','&&**p!='\r')
+		++*p;
+	t.len=*p-t.p;
+	return t;
+}
+
+/// opcode spelled by `t`, looked up by its first letter, -1 when unknown
+int readOpcode(TOKEN t) {
+	int c=-1;
+	switch(t.len>0?t.p[0]:0) {
+	case 'M': c=t.len>1&&t.p[1]=='O'?MOV:MUL; break;
+	case 'A': c=t.len>1&&t.p[1]=='D'?ADD:AND; break;
+	case 'S': c=SUB; break;
+	case 'D': c=DIV; break;
+	case 'E': c=EXIT; break;
+	case 'O': c=OR; break;
+	case 'X': c=XOR; break;
+	}
+	if(c<0||(int)strlen(opcodes[c].name)!=t.len||memcmp(opcodes[c].name,t.p,t.len)!=0)
+		return -1;
+	return c;
+}
+
 /**
-read input from stdin.
+decode the line at `*cursor` into `inst` and move past it,
+the line is NUL-terminated in place, no line length limit.
 
 return:
  1 : success
  2 : illegal instruction
 -1 : input EOF
 **/
-int readInst(INST **inst) {
-	const char *tok=" ";
-	char *chr,*op;
-	char input[32]="",decode[32]="";
-	if(fgets(input,31,stdin)==NULL||strlen(input)<=3)
+int readInst(char **cursor,INST *inst) {
+	char *input=*cursor,*p,*eol;
+	TOKEN op;
+	if(*input=='\0')
 		return -1;
-	else {
-		/// replace newline to EOF, if newline exist
-		if(input[strlen(input)-1]=='\n')
-			input[strlen(input)-1]='\0';
-
-		strcpy(decode,input);
-
-		/// remove ',', if it exist
-		chr=strchr(decode,',');
-		if(chr!=NULL)
-			while(*chr!='\0')
-			{
-				*chr=*(chr+1);
-				++chr;
-			}
-		op=strtok(decode,tok);
-	}
+	eol=strchr(input,'\n');
+	/// as before, a line of at most 3 characters ends the program
+	if((eol?eol-input+1:(long)strlen(input))<=3)
+		return -1;
+	if(eol) {
+		*eol='\0';
+		*cursor=eol+1;
+	} else
+		*cursor=input+strlen(input);
+	p=input;
 
 	enum code opcode;
+	int code;
 	/// read opcode
-	if(strcmp(op,"MOV")==0) opcode=MOV;
-	else if(strcmp(op,"ADD")==0) opcode=ADD;
-	else if(strcmp(op,"SUB")==0) opcode=SUB;
-	else if(strcmp(op,"MUL")==0) opcode=MUL;
-	else if(strcmp(op,"DIV")==0) opcode=DIV;
-	else if(strcmp(op,"EXIT")==0) opcode=EXIT;
-	else if(strcmp(op,"AND")==0) opcode=AND;
-	else if(strcmp(op,"OR")==0) opcode=OR;
-	else if(strcmp(op,"XOR")==0) opcode=XOR;
-	else {
-		error("un-define opcode: '%s'\n",op);
+	op=nextToken(&p);
+	if((code=readOpcode(op))<0) {
+		error("un-define opcode: '%.*s'\n",op.len,op.p);
 		return 2;
 	}
+	opcode=code;
 
 	enum op_type op1_t;
 	int op1_v;
 	/// read op1
-	op=strtok(NULL,tok);
-	if(!readOP(input,op,&op1_t,&op1_v))
+	if(!readOP(input,nextToken(&p),&op1_t,&op1_v))
 		return 2;
 
 	enum op_type op2_t;
 	int op2_v;
 	/// read op2 except EXIT
 	if(opcode!=EXIT) {
-		op=strtok(NULL,tok);
-		if(!readOP(input,op,&op2_t,&op2_v))
+		if(!readOP(input,nextToken(&p),&op2_t,&op2_v))
 			return 2;
 	} else {
 		op2_t=CONST;
 		op2_v=0;
 	}
 
+	enum op_type op3_t=NONE;
+	int op3_v=0;
+	/// read op3 of the 3-address form
+	if((op=nextToken(&p)).len>0) {
+		if(opcode==MOV||opcode==EXIT) {
+			error("%s\n","MOV and EXIT take no third operand");
+			return 2;
+		}
+		if(!readOP(input,op,&op3_t,&op3_v))
+			return 2;
+	}
+
 	/// According to opcode, check op1 and op2
 	switch(opcode) {
 	case MOV:
@@ -251,65 +296,18 @@ int readInst(INST **inst) {
 		break;
 
 	case ADD:
-		if(op1_t!=REG) {
-			error("%s\n","op1 of ADD is only REG"); return 2;
-		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of ADD is only REG"); return 2;
-		}
-		break;
-
 	case SUB:
-		if(op1_t!=REG) {
-			error("%s\n","op1 of SUB is only REG"); return 2;
-		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of SUB is only REG"); return 2;
-		}
-		break;
-
 	case MUL:
-		if(op1_t!=REG) {
-			error("%s\n","op1 of MUL is only REG"); return 2;
-		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of MUL is only REG"); return 2;
-		}
-		break;
-
 	case DIV:
-		if(op1_t!=REG) {
-			error("%s\n","op1 of DIV is only REG"); return 2;
-		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of DIV is only REG"); return 2;
-		}
-		break;
-
 	case AND:
-		if(op1_t!=REG) {
-			error("%s\n","op1 of AND is only REG"); return 2;
-		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of AND is only REG"); return 2;
-		}
-		break;
-
 	case OR:
-		if(op1_t!=REG) {
-			error("%s\n","op1 of OR is only REG"); return 2;
-		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of OR is only REG"); return 2;
-		}
-		break;
-
 	case XOR:
 		if(op1_t!=REG) {
-			error("%s\n","op1 of XOR is only REG"); return 2;
+			error("op1 of %s is only REG\n",opcodes[opcode].name); return 2;
 		}
-		if(op2_t!=REG) {
-			error("%s\n","op2 of XOR is only REG"); return 2;
+		/// the right operand may be an immediate or a memory word (ISA extension)
+		if(op3_t!=NONE&&op2_t!=REG) {
+			error("op2 of 3-address %s is only REG\n",opcodes[opcode].name); return 2;
 		}
 		break;
 
@@ -320,96 +318,758 @@ int readInst(INST **inst) {
 		}
 	}
 
-	(*inst)=(INST*)malloc(sizeof(INST));
-	(*inst)->opcode=opcode;
-	(*inst)->op1_type=op1_t;
-	(*inst)->op2_type=op2_t;
-	(*inst)->op1_value=op1_v;
-	(*inst)->op2_value=op2_v;
+	inst->opcode=opcode;
+	inst->op1_type=op1_t;
+	inst->op2_type=op2_t;
+	inst->op1_value=op1_v;
+	inst->op2_value=op2_v;
+	inst->op3_type=op3_t;
+	inst->op3_value=op3_v;
+
+	return 1;
+}
+
+/// -j: translate the program into native x86-64 code and run that instead of execute()
+/// r0..r{REG_COUNT-1} live in host registers, so it needs REG_COUNT <= 8
+/// elsewhere -j falls back to the interpreter
+#if (defined(__x86_64__)||defined(_M_X64))&&REG_COUNT<=8
+#define JIT_ENABLED 1
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/// compiled program, `fn(r,mem,fault)` has the effect of execute(op,r,mem,fault)
+typedef void (*JIT_FN)(int *r,int *mem,char *fault);
+
+typedef struct JIT {
+	unsigned char *code; /// executable once compiled
+	unsigned char *p;    /// next byte to emit
+	size_t size;
+} JIT;
+
+/// host registers, numbered as in the ModRM encoding
+enum host { RAX,RCX,RDX,RBX,RSP,RBP,RSI,RDI,R8,R9,R10,R11,R12,R13,R14,R15 };
+
+/// host register of every guest register, rax and rdx are left to idiv,
+/// rsi holds divisors, r10 `r`, r11 `mem` and rcx `fault`
+const enum host guest[8]={RBX,RBP,R12,R13,R14,R15,R8,R9};
+
+void emit1(JIT *j,int b) {
+	*j->p++=(unsigned char)b;
+}
+
+void emit4(JIT *j,int v) {
+	memcpy(j->p,&v,4);
+	j->p+=4;
+}
+
+/// REX prefix for `reg` in ModRM.reg and `rm` in ModRM.rm, omitted when it adds nothing
+/// `w` selects 64-bit operands
+void emit_rex(JIT *j,int w,int reg,int rm) {
+	int b=0x40|(w?8:0)|(reg&8?4:0)|(rm&8?1:0);
+	if(b!=0x40)
+		emit1(j,b);
+}
+
+/// one or two opcode bytes, 0x0FAF is imul
+void emit_opcode(JIT *j,int opcode) {
+	if(opcode>0xff)
+		emit1(j,opcode>>8);
+	emit1(j,opcode&0xff);
+}
+
+/// `opcode reg, rm` between registers, 32-bit unless `w`
+void emit_rr(JIT *j,int w,int opcode,int reg,int rm) {
+	emit_rex(j,w,reg,rm);
+	emit_opcode(j,opcode);
+	emit1(j,0xC0|(reg&7)<<3|(rm&7));
+}
+
+/// `opcode reg, [base+disp]`, `base` is never rsp/r12 so no SIB byte is needed
+void emit_rm(JIT *j,int opcode,int reg,int base,int disp) {
+	emit_rex(j,0,reg,base);
+	emit_opcode(j,opcode);
+	emit1(j,0x80|(reg&7)<<3|(base&7));
+	emit4(j,disp);
+}
+
+/// load form `reg = reg <op> rm` of every arithmetic handler, indexed from H_ADD
+const int op_load[]={0x03,0x2B,0x0FAF,0,0x23,0x0B,0x33};
+/// ModRM.reg of `0x81 /digit rm, imm32`, mul uses 0x69 instead
+const int op_digit[]={0,5,0,0,4,1,6};
+
+/// `r = rs`, nothing when they are the same register
+void emit_copy(JIT *j,int r,int rs) {
+	if(r!=rs)
+		emit_rr(j,0,0x8B,r,rs);
+}
+
+/// fault[i] = `f`
+void emit_fault(JIT *j,int i,enum fault f) {
+	emit1(j,0xC6);
+	emit1(j,0x80|RCX);
+	emit4(j,i);
+	emit1(j,f);
+}
+
+/// rel8 jump at `at` lands on the next byte to emit
+void emit_land(JIT *j,unsigned char *at) {
+	*at=(unsigned char)(j->p-at-1);
+}
+
+/// one instruction at index `i`
+void jit_op(JIT *j,const OP *op,int i) {
+	int k=(op->handler-H_ADD_R)/3,kind=(op->handler-H_ADD_R)%3;
+	int d,a,t,dv;
+	unsigned char *skip,*skip_divisor=NULL,*done,*done_overflow;
+	/// a store writes memory, everything else the register `op->d`
+	if(op->handler==H_STORE) {
+		emit_rm(j,0x89,guest[op->b],R11,op->d*4);
+		return;
+	}
+	d=guest[op->d];
+	switch(op->handler) {
+	case H_MOV_R: emit_copy(j,d,guest[op->b]); return;
+	case H_MOV_C: emit_rex(j,0,0,d); emit1(j,0xB8|(d&7)); emit4(j,op->b); return;
+	case H_MOV_M: emit_rm(j,0x8B,d,R11,op->b*4); return;
+	case H_DIV_R: case H_DIV_C: case H_DIV_M:
+		a=guest[op->a];
+		if(kind==CONST&&op->b==0) {
+			emit_fault(j,i,FAULT_DIV_ZERO);
+			emit_copy(j,d,a);
+			return;
+		}
+		dv=kind==REG?guest[op->b]:RSI;
+		done=done_overflow=NULL;
+		if(kind==CONST) {
+			emit1(j,0xB8|RSI);
+			emit4(j,op->b);
+		} else {
+			if(kind==ADDR)
+				emit_rm(j,0x8B,RSI,R11,op->b*4);
+			/// a zero divisor keeps the dividend, as execute() does
+			emit_rr(j,0,0x85,dv,dv);
+			emit1(j,0x75);
+			skip=j->p;
+			emit1(j,0);
+			emit_fault(j,i,FAULT_DIV_ZERO);
+			emit_copy(j,d,a);
+			emit1(j,0xEB);
+			done=j->p;
+			emit1(j,0);
+			emit_land(j,skip);
+		}
+		/// so does INT_MIN / -1, which idiv would trap on
+		if(kind!=CONST||op->b==-1) {
+			emit_rr(j,0,0x81,7,a);
+			emit4(j,INT_MIN);
+			emit1(j,0x75);
+			skip=j->p;
+			emit1(j,0);
+			if(kind!=CONST) {
+				emit_rr(j,0,0x81,7,dv);
+				emit4(j,-1);
+				emit1(j,0x75);
+				skip_divisor=j->p;
+				emit1(j,0);
+			}
+			emit_fault(j,i,FAULT_DIV_OVERFLOW);
+			emit_copy(j,d,a);
+			emit1(j,0xEB);
+			done_overflow=j->p;
+			emit1(j,0);
+			emit_land(j,skip);
+			if(kind!=CONST)
+				emit_land(j,skip_divisor);
+		}
+		emit_copy(j,RAX,a);
+		emit1(j,0x99);
+		emit_rr(j,0,0xF7,7,dv);
+		emit_copy(j,d,RAX);
+		if(done)
+			emit_land(j,done);
+		if(done_overflow)
+			emit_land(j,done_overflow);
+		return;
+	default:
+		/// d = a <op> b, through rax unless d is a
+		a=guest[op->a];
+		t=d==a?d:RAX;
+		emit_copy(j,t,a);
+		if(kind==REG)
+			emit_rr(j,0,op_load[k],t,guest[op->b]);
+		else if(kind==ADDR)
+			emit_rm(j,op_load[k],t,R11,op->b*4);
+		else if(op_load[k]==0x0FAF) {
+			emit_rr(j,0,0x69,t,t);
+			emit4(j,op->b);
+		} else {
+			emit_rr(j,0,0x81,op_digit[k],t);
+			emit4(j,op->b);
+		}
+		emit_copy(j,d,t);
+	}
+}
+
+/// callee-saved registers the code uses, rsi and rdi are callee-saved on Windows only
+#ifdef _WIN32
+const enum host saved[]={RBX,RBP,R12,R13,R14,R15,RSI,RDI};
+#else
+const enum host saved[]={RBX,RBP,R12,R13,R14,R15};
+#endif
+#define SAVED (int)(sizeof(saved)/sizeof(saved[0]))
 
-	//    print(*inst);
+/// translate `op[0..n]` into executable memory, NULL when it cannot be mapped
+JIT_FN jit_compile(JIT *j,const OP *op,int n) {
+	int i;
+	/// the longest instruction, a DIV on memory, takes under 80 bytes
+	j->size=(size_t)n*80+256;
+#ifdef _WIN32
+	j->code=(unsigned char*)VirtualAlloc(NULL,j->size,MEM_COMMIT|MEM_RESERVE,PAGE_READWRITE);
+	if(j->code==NULL)
+		return NULL;
+#else
+	j->code=(unsigned char*)mmap(NULL,j->size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	if(j->code==MAP_FAILED)
+		return NULL;
+#endif
+	j->p=j->code;
+
+	for(i=0;i!=SAVED;++i) {
+		emit_rex(j,0,0,saved[i]);
+		emit1(j,0x50|(saved[i]&7));
+	}
+	/// arguments r, mem, fault into r10, r11, rcx
+#ifdef _WIN32
+	emit_rr(j,1,0x8B,R10,RCX);
+	emit_rr(j,1,0x8B,R11,RDX);
+	emit_rr(j,1,0x8B,RCX,R8);
+#else
+	emit_rr(j,1,0x8B,R10,RDI);
+	emit_rr(j,1,0x8B,R11,RSI);
+	emit_rr(j,1,0x8B,RCX,RDX);
+#endif
+	for(i=0;i!=REG_COUNT;++i)
+		emit_rm(j,0x8B,guest[i],R10,i*4);
+
+	for(i=0;op[i].handler!=H_EXIT;++i)
+		jit_op(j,&op[i],i);
+
+	for(i=0;i!=REG_COUNT;++i)
+		emit_rm(j,0x89,guest[i],R10,i*4);
+	for(i=SAVED-1;i>=0;--i) {
+		emit_rex(j,0,0,saved[i]);
+		emit1(j,0x58|(saved[i]&7));
+	}
+	emit1(j,0xC3);
 
+	/// never writable and executable at once
+#ifdef _WIN32
+	DWORD old;
+	if(!VirtualProtect(j->code,j->size,PAGE_EXECUTE_READ,&old))
+		return NULL;
+#else
+	if(mprotect(j->code,j->size,PROT_READ|PROT_EXEC)!=0)
+		return NULL;
+#endif
+	return (JIT_FN)(void*)j->code;
+}
+
+void jit_free(JIT *j) {
+	if(j->code==NULL)
+		return;
+#ifdef _WIN32
+	VirtualFree(j->code,0,MEM_RELEASE);
+#else
+	munmap(j->code,j->size);
+#endif
+}
+#else
+#define JIT_ENABLED 0
+#endif
+
+/// -w<file>: write the binary trace of the `n` instructions run, see trace.h
+/// return 0 when the file cannot be written
+int writeTrace(const char *path,const INST *prog,const char *fault,int n) {
+	FILE *f=fopen(path,"wb");
+	TRACE_HEADER h={{'S','I','M','T'},TRACE_VERSION,REG_COUNT,(uint32_t)memsize,(uint64_t)n,sizeof(TRACE_RECORD),0};
+	TRACE_RECORD block[4096];
+	int i,k=0,ok;
+	if(f==NULL)
+		return 0;
+	ok=fwrite(&h,sizeof(h),1,f)==1;
+	for(i=0;i!=n&&ok;++i) {
+		object_record(&prog[i],&block[k]);
+		block[k++].flags=fault[i]==FAULT_DIV_ZERO?TRACE_FAULT:fault[i]==FAULT_DIV_OVERFLOW?TRACE_OVERFLOW:0;
+		if(k==4096||i==n-1) {
+			ok=fwrite(block,sizeof(TRACE_RECORD),k,f)==(size_t)k;
+			k=0;
+		}
+	}
+	return fclose(f)==0&&ok;
+}
+
+/// -l<file>: line map written by the compiler's -l<file>, one `<line> <kind>` row per instruction
+/// line 0 is the code the compiler appends after the last statement
+const char *kind_name[]={"load","store","spill","arithmetic","exit"};
+#define KINDS 5
+
+typedef struct LINEMAP {
+	int rows;                      /// instructions the map covers
+	int *line;                     /// input line of every instruction
+	char *kind;                    /// index in kind_name
+	int lines;                     /// highest line + 1
+	long long *line_cycles;        /// cycles charged to every line
+	int *line_count;               /// instructions of every line
+	long long kind_cycles[KINDS];
+	int kind_count[KINDS];
+} LINEMAP;
+
+/// read the map from `path`, return 0 when it cannot be opened
+int readLineMap(const char *path,LINEMAP *m) {
+	FILE *f=fopen(path,"r");
+	char *text,*p,*end;
+	size_t size;
+	int capacity=0,k;
+	memset(m,0,sizeof(*m));
+	if(f==NULL)
+		return 0;
+	text=readAll(f,&size);
+	fclose(f);
+	for(p=text;*p;p=*p?p+1:p) {
+		long line=strtol(p,&end,10);
+		if(*p!='#'&&end!=p) {
+			for(p=end;*p==' '||*p=='\t';++p);
+			for(k=0;k!=KINDS&&strncmp(p,kind_name[k],strlen(kind_name[k]))!=0;++k);
+			if(k!=KINDS&&line>=0) {
+				if(m->rows==capacity) {
+					capacity=capacity?capacity*2:1024;
+					m->line=(int*)realloc(m->line,capacity*sizeof(int));
+					m->kind=(char*)realloc(m->kind,capacity);
+				}
+				m->line[m->rows]=(int)line;
+				m->kind[m->rows++]=(char)k;
+				if(line>=m->lines)
+					m->lines=(int)line+1;
+			}
+		}
+		while(*p&&*p!='\n')
+			++p;
+	}
+	free(text);
+	m->line_cycles=(long long*)calloc(m->lines,sizeof(long long));
+	m->line_count=(int*)calloc(m->lines,sizeof(int));
 	return 1;
 }
 
+/// charge `cc` cycles of instruction `i` to its line and kind
+void attribute(LINEMAP *m,int i,int cc) {
+	if(i>=m->rows)
+		return;
+	m->line_cycles[m->line[i]]+=cc;
+	++m->line_count[m->line[i]];
+	m->kind_cycles[(int)m->kind[i]]+=cc;
+	++m->kind_count[(int)m->kind[i]];
+}
+
+void printLineMap(const LINEMAP *m,long long total,int n) {
+	int l,k;
+	if(m->rows!=n)
+		printf("line map has %d instructions, the program %d\n",m->rows,n);
+	printf("Cycles by source line\n");
+	for(l=1;l<=m->lines;++l) {
+		/// the epilogue, line 0, comes last
+		int at=l%m->lines;
+		if(m->line_count[at]==0)
+			continue;
+		if(at)
+			printf("  line %-6d",at);
+		else
+			printf("  epilogue   ");
+		printf("%8d instructions %12lldcc %6.1f%%\n",m->line_count[at],m->line_cycles[at],total?100.0*m->line_cycles[at]/total:0);
+	}
+	printf("Cycles by kind\n");
+	for(k=0;k!=KINDS;++k)
+		if(m->kind_count[k])
+			printf("  %-11s%8d instructions %12lldcc %6.1f%%\n",kind_name[k],m->kind_count[k],m->kind_cycles[k],total?100.0*m->kind_cycles[k]/total:0);
+}
+
+void freeLineMap(LINEMAP *m) {
+	free(m->line);
+	free(m->kind);
+	free(m->line_cycles);
+	free(m->line_count);
+}
+
+/// -i<file>: run the program once for every line of `file`, the initial memory of one image
+/// images run BATCH_LANES at a time, registers and memory are stored [index][lane]
+/// so one instruction is a loop over contiguous lanes, 8 per AVX2 instruction
+#define BATCH_LANES 256
+
+#if defined(__GNUC__)&&(defined(__x86_64__)||defined(__i386__))
+#include <immintrin.h>
+#define BATCH_AVX2 1
+
+/// d = a <op> b over all lanes, `h` is the register form of the handler
+__attribute__((target("avx2")))
+void batch_op_avx2(enum handler h,int *d,const int *a,const int *b) {
+	int l;
+#define LANES(e) \
+	for(l=0;l!=BATCH_LANES;l+=8) { \
+		__m256i x=_mm256_loadu_si256((const __m256i*)(a+l)),y=_mm256_loadu_si256((const __m256i*)(b+l)); \
+		_mm256_storeu_si256((__m256i*)(d+l),e); \
+	} \
+	break;
+	switch(h) {
+	case H_ADD_R: LANES(_mm256_add_epi32(x,y))
+	case H_SUB_R: LANES(_mm256_sub_epi32(x,y))
+	case H_MUL_R: LANES(_mm256_mullo_epi32(x,y))
+	case H_AND_R: LANES(_mm256_and_si256(x,y))
+	case H_OR_R:  LANES(_mm256_or_si256(x,y))
+	case H_XOR_R: LANES(_mm256_xor_si256(x,y))
+	default: break;
+	}
+#undef LANES
+}
+#else
+#define BATCH_AVX2 0
+#endif
+
+/// portable batch_op_avx2()
+void batch_op(enum handler h,int *d,const int *a,const int *b) {
+	int l;
+#define LANES(e) for(l=0;l!=BATCH_LANES;++l) d[l]=e; break;
+	switch(h) {
+	case H_ADD_R: LANES((int)((unsigned)a[l]+(unsigned)b[l]))
+	case H_SUB_R: LANES((int)((unsigned)a[l]-(unsigned)b[l]))
+	case H_MUL_R: LANES((int)((unsigned)a[l]*(unsigned)b[l]))
+	case H_AND_R: LANES(a[l]&b[l])
+	case H_OR_R:  LANES(a[l]|b[l])
+	case H_XOR_R: LANES(a[l]^b[l])
+	default: break;
+	}
+#undef LANES
+}
+
+/// run `op` over BATCH_LANES images, a faulting DIV keeps the dividend and counts in `faults`
+/// as execute() does, by zero or of INT_MIN by -1
+void batch_execute(const OP *op,int *r,int *mem,int *faults,int avx2) {
+	int konst[BATCH_LANES],l,kind;
+	const OP *p;
+	int *d;
+	const int *a,*b;
+	for(p=op;p->handler!=H_EXIT;++p) {
+		if(p->handler==H_STORE) {
+			d=mem+p->d*BATCH_LANES;
+			a=b=r+p->b*BATCH_LANES;
+			kind=REG;
+		} else {
+			d=r+p->d*BATCH_LANES;
+			a=r+p->a*BATCH_LANES;
+			kind=p->handler<H_STORE?p->handler-H_MOV_R:(p->handler-H_ADD_R)%3;
+			if(kind==CONST) {
+				for(l=0;l!=BATCH_LANES;++l)
+					konst[l]=p->b;
+				b=konst;
+			} else
+				b=(kind==REG?r:mem)+p->b*BATCH_LANES;
+		}
+		/// the register form of the handler, a store copies like a MOV
+		enum handler h=p->handler<=H_STORE?H_MOV_R:p->handler-kind;
+		if(h==H_MOV_R)
+			memcpy(d,b,BATCH_LANES*sizeof(int));
+		else if(h==H_DIV_R) {
+			for(l=0;l!=BATCH_LANES;++l)
+				if(b[l]==0||(b[l]==-1&&a[l]==INT_MIN)) {
+					d[l]=a[l];
+					++faults[l];
+				} else
+					d[l]=a[l]/b[l];
+		}
+#if BATCH_AVX2
+		else if(avx2)
+			batch_op_avx2(h,d,a,b);
+#endif
+		else
+			batch_op(h,d,a,b);
+	}
+}
+
+/// run every image of `images`, one line of memory words each, and write the result table
+/// returns the number of images
+int batch(const OP *op,const char *images) {
+	int *r=(int*)malloc(REG_COUNT*BATCH_LANES*sizeof(int));
+	int *mem=(int*)malloc((size_t)memsize*BATCH_LANES*sizeof(int));
+	int faults[BATCH_LANES];
+	int count=0,lanes,w,l,avx2=0;
+	const char *p=images;
+	char *end;
+#if BATCH_AVX2
+	avx2=__builtin_cpu_supports("avx2");
+#endif
+	printf("image r0 r1 r2 faults\n");
+	while(*p) {
+		memset(r,0,REG_COUNT*BATCH_LANES*sizeof(int));
+		memset(mem,0,(size_t)memsize*BATCH_LANES*sizeof(int));
+		memset(faults,0,sizeof(faults));
+		for(lanes=0;lanes!=BATCH_LANES&&*p;++lanes) {
+			for(w=0;*p&&*p!='\n';++w) {
+				long v=strtol(p,&end,10);
+				if(end==p) {
+					/// not a number, skip to the next separator
+					while(*p&&*p!='\n'&&!isspace((unsigned char)*p))
+						++p;
+					while(*p==' '||*p=='\t'||*p=='\r'||*p==',')
+						++p;
+					--w;
+					continue;
+				}
+				if(w<memsize)
+					mem[w*BATCH_LANES+lanes]=(int)v;
+				for(p=end;*p==' '||*p=='\t'||*p=='\r'||*p==',';++p);
+			}
+			if(*p=='\n')
+				++p;
+		}
+		batch_execute(op,r,mem,faults,avx2);
+		for(l=0;l!=lanes;++l) {
+			char row[64],*q=row;
+			q=put_int(q,count+l,0);
+			for(w=0;w!=3;++w) {
+				*q++=' ';
+				q=put_int(q,r[w*BATCH_LANES+l],0);
+			}
+			*q++=' ';
+			q=put_int(q,faults[l],0);
+			*q++='\n';
+			fwrite(row,1,q-row,stdout);
+		}
+		count+=lanes;
+	}
+	free(r);
+	free(mem);
+	return count;
+}
+
 int main(int argc,char **argv) {
 	/// comment here to read input from standard input or file
 	/// comment here to read input from standard input or file
 	/// comment here to read input from standard input or file
 	// freopen("input.txt","r",stdin);
-	freopen("output.txt","w",stdout);
 
-	INST *inst;
-	int r[8],state;
-	int mem[64]={0};
-	int i;
+	INST *inst,*prog=NULL;
+	char *text,*cursor;
+	size_t size;
+	OP *op;
+	char *fault;
+	int r[REG_COUNT]={0},state;
+	int *mem;
+	int i,n=0,capacity=0,words=0,cc,bench=0,jit=0,width=0,cached=0;
+	int analyze_only=0;            /// -a: decode and report the static analysis, nothing runs
+	int trace=1;                  /// -t<level>: 0 only reports the result, 1 also every instruction
+	const char *path="output.txt"; /// -o<path>, `-o-` for stdout
+	const char *images=NULL;       /// -i<path>, batch mode
+	const char *line_map=NULL;     /// -l<path>, cycles per source line
+	const char *trace_path=NULL;   /// -w<path>, binary trace for reprice
+	const char *object=NULL;       /// -x<path>, binary object instead of the text on stdin
+	LINEMAP map={0};
+	clock_t start;
+	double decoded;
+	ANALYSIS a;
+	/// options start with a letter, everything else initializes memory
 	for(i=1;i!=argc;++i)
-		mem[i-1]=atoi(argv[i]);
+		if(argv[i][0]=='-'&&argv[i][1]=='p')
+			width=max(atoi(argv[i]+2),1);
+		else if(strcmp(argv[i],"-c")==0)
+			cached=1;
+		else if(argv[i][0]=='-'&&argv[i][1]=='m')
+			memsize=max(atoi(argv[i]+2),3);
+		else if(strcmp(argv[i],"-b")==0)
+			bench=1;
+		else if(strcmp(argv[i],"-a")==0)
+			analyze_only=1;
+		else if(strcmp(argv[i],"-j")==0)
+			jit=1;
+		else if(argv[i][0]=='-'&&argv[i][1]=='t')
+			trace=atoi(argv[i]+2);
+		else if(argv[i][0]=='-'&&argv[i][1]=='o')
+			path=argv[i]+2;
+		else if(argv[i][0]=='-'&&argv[i][1]=='i')
+			images=argv[i]+2;
+		else if(argv[i][0]=='-'&&argv[i][1]=='l')
+			line_map=argv[i]+2;
+		else if(argv[i][0]=='-'&&argv[i][1]=='w')
+			trace_path=argv[i]+2;
+		else if(argv[i][0]=='-'&&argv[i][1]=='x')
+			object=argv[i]+2;
+	/// an object is mapped and unpacked, nothing to parse, its header may ask for more memory
 	state=1;
-	int totalClock=0;
+	text=NULL;
+	start=clock();
+	if(object) {
+		const void *data=map_file(object,&size);
+		const char *err;
+		if(data==NULL) {
+			fprintf(stderr,"cannot read '%s'\n",object);
+			return 1;
+		}
+		err=object_read(data,size,&prog,&n,&memsize);
+		unmap_file(data,size);
+		if(err) {
+			fprintf(stderr,"'%s': %s\n",object,err);
+			return 1;
+		}
+		state=n>0&&prog[n-1].opcode==EXIT?0:-1;
+	}
+	if(strcmp(path,"-")!=0&&freopen(path,"w",stdout)==NULL) {
+		fprintf(stderr,"cannot open '%s'\n",path);
+		return 1;
+	}
+	/// the trace is written in large blocks
+	setvbuf(stdout,NULL,_IOFBF,1<<20);
+	mem=(int*)calloc(memsize,sizeof(int));
+	analyze_init(&a,width,cached,memsize);
+	if(line_map&&!readLineMap(line_map,&map)) {
+		fprintf(stderr,"cannot open '%s'\n",line_map);
+		return 1;
+	}
+	for(i=1;i!=argc;++i)
+		if(!isalpha((unsigned char)argv[i][argv[i][0]=='-'])&&words<memsize)
+			mem[words++]=atoi(argv[i]);
 
+	/// decode the whole program up to its EXIT once
+	if(!object) {
+		text=readAll(stdin,&size);
+		start=clock();
+	}
+	cursor=text;
+	if(analyze_only) {
+		/// a single decode pass, every instruction is accounted for as soon as it is decoded
+		INST one;
+		for(i=0;i!=n;++i)
+			analyze_inst(&a,&prog[i]);
+		while(state>0)
+			if((state=readInst(&cursor,&one))==1) {
+				analyze_inst(&a,&one);
+				if(one.opcode==EXIT)
+					state=0;
+			}
+		if(text)
+			size=cursor-text;
+		decoded=(double)(clock()-start)/CLOCKS_PER_SEC;
+		if(state!=0) {
+			printf("**********************************\n");
+			printf("ERROR ending without EXIT\n");
+			printf("**********************************\n");
+		}
+		analyze_print(&a,stdout);
+		if(bench)
+			fprintf(stderr,"%d instructions: analyzed in %.3fs (%.1fMB/s)\n",
+				a.instructions,decoded,decoded>0?size/decoded/1e6:0);
+		analyze_free(&a);
+		free(text);
+		free(prog);
+		free(mem);
+		return 0;
+	}
 	while(state>0) {
-		if((state=readInst(&inst))!=1)
+		if(n==capacity) {
+			capacity=capacity?capacity*2:1024;
+			prog=(INST*)realloc(prog,capacity*sizeof(INST));
+		}
+		if((state=readInst(&cursor,&prog[n]))!=1)
 			continue;
-		print(inst);
-		switch(inst->opcode) {
-		case MOV:
-			if(inst->op1_type==REG)
-				switch(inst->op2_type) {
-				case REG:   r[inst->op1_value]=r[inst->op2_value]; totalClock+=10; break;
-				case CONST: r[inst->op1_value]=inst->op2_value; totalClock+=10; break;
-				case ADDR:   r[inst->op1_value]=mem[inst->op2_value/4]; totalClock+=200; break;
-				}
-			else {
-				mem[inst->op1_value/4]=r[inst->op2_value];
-				totalClock+=200;
-			}
-			break;
-		case ADD:
-			r[inst->op1_value]+=r[inst->op2_value];
-			totalClock+=10;
-			break;
-		case SUB:
-			r[inst->op1_value]-=r[inst->op2_value];
-			totalClock+=10;
-			break;
-		case MUL:
-			r[inst->op1_value]*=r[inst->op2_value];
-			totalClock+=30;
-			break;
-		case DIV:
-			if(r[inst->op2_value]==0) {
-				printf("**********************************\n");
+		if(prog[n++].opcode==EXIT)
+			state=0;
+	}
+	if(text)
+		size=cursor-text;
+	/// a program without EXIT still stops at the end
+	op=(OP*)malloc((n+1)*sizeof(OP));
+	for(i=0;i!=n;++i)
+		op[i]=lower(&prog[i]);
+	op[n].handler=H_EXIT;
+	fault=(char*)calloc(n+1,1);
+	decoded=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+	/// batch mode replaces the single run and its trace by one table row per image
+	int batched=0;
+	if(images) {
+		FILE *f=fopen(images,"r");
+		char *image_text;
+		if(f==NULL) {
+			fprintf(stderr,"cannot open '%s'\n",images);
+			return 1;
+		}
+		image_text=readAll(f,&size);
+		fclose(f);
+		start=clock();
+		batched=batch(op,image_text);
+		double ran=(double)(clock()-start)/CLOCKS_PER_SEC;
+		if(bench)
+			fprintf(stderr,"%d images: executed in %.3fs (%.1fM instructions/s)\n",
+				batched,ran,ran>0?(double)batched*n/ran/1e6:0);
+		free(image_text);
+		trace=0;
+		jit=0;
+	}
+
+	double compiled=0;
+#if JIT_ENABLED
+	JIT code={0};
+	JIT_FN fn=NULL;
+	if(jit) {
+		start=clock();
+		if((fn=jit_compile(&code,op,n))==NULL)
+			fprintf(stderr,"-j: cannot map executable memory, interpreting\n");
+		compiled=(double)(clock()-start)/CLOCKS_PER_SEC;
+	}
+#else
+	if(jit)
+		fprintf(stderr,"-j: no JIT for this host or REG_COUNT, interpreting\n");
+#endif
+
+	start=clock();
+#if JIT_ENABLED
+	if(fn)
+		fn(r,mem,fault);
+	else
+#endif
+	if(!images)
+		execute(op,r,mem,fault);
+	double executed=(double)(clock()-start)/CLOCKS_PER_SEC;
+#if JIT_ENABLED
+	jit_free(&code);
+#endif
+
+	if(trace_path&&!writeTrace(trace_path,prog,fault,n))
+		fprintf(stderr,"cannot write '%s'\n",trace_path);
+
+	/// the program is straight-line, so its trace and timing do not depend on the values
+	for(i=0;i!=n;++i) {
+		inst=&prog[i];
+		cc=analyze_inst(&a,inst);
+		if(line_map)
+			attribute(&map,i,cc);
+		if(trace)
+			print(inst,cc);
+		if(fault[i]) {
+			printf("**********************************\n");
+			if(fault[i]==FAULT_DIV_ZERO)
 				printf("ERROR divisor is not equal to 0\n");
-				printf("**********************************\n");
-			}
 			else
-				r[inst->op1_value]/=r[inst->op2_value];
-			totalClock+=50;
-			break;
-		case AND:
-			r[inst->op1_value]&=r[inst->op2_value];
-			totalClock+=10;
-			break;
-		case OR:
-			r[inst->op1_value]|=r[inst->op2_value];
-			totalClock+=10;
-			break;
-		case XOR:
-			r[inst->op1_value]^=r[inst->op2_value];
-			totalClock+=10;
-			break;
-		case EXIT:
+				printf("ERROR quotient of INT_MIN / -1 overflows\n");
+			printf("**********************************\n");
+		}
+		if(inst->opcode==EXIT&&trace) {
 			printf("-------------------------------------------\n");
 			if(inst->op1_value==0)
 				printf("exit normally\n");
 			else
 				printf("the expression cannot be evaluated\n");
-			state=0;
-			totalClock+=20;
-			break;
 		}
-		free(inst);
 	}
 
 	if(state!=0) {
@@ -419,9 +1079,29 @@ int main(int argc,char **argv) {
 	}
 
 	printf("\n");
-	for(i=0;i!=3;++i)
-		printf("r[%d] = %d\n",i,r[i]);
-	printf("Total clock cycles are %d\n",totalClock);
+	if(!images)
+		for(i=0;i!=3;++i)
+			printf("r[%d] = %d\n",i,r[i]);
+	printf("Total clock cycles are %lld\n",a.cycles);
+	if(a.pipe.width)
+		printf("Pipelined clock cycles are %d (issue width %d)\n",a.pipe.finish,a.pipe.width);
+	if(a.cache.on)
+		printf("Cache hits %d, misses %d\n",a.cache.hits,a.cache.misses);
+	if(line_map)
+		printLineMap(&map,a.cycles,n);
+	/// -b: decode and execute speed on stderr, the trace stays in output.txt
+	if(bench&&!images)
+		fprintf(stderr,"%d instructions: decoded in %.3fs (%.1fMB/s), executed in %.3fs (%.1fM instructions/s)\n",
+			n,decoded,decoded>0?size/decoded/1e6:0,executed,executed>0?n/executed/1e6:0);
+	if(bench&&jit)
+		fprintf(stderr,"jit compiled in %.3fs\n",compiled);
+	free(text);
+	free(prog);
+	free(op);
+	free(fault);
+	free(mem);
+	analyze_free(&a);
+	freeLineMap(&map);
 
 	return 0;
 }
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "machine.h"
+#include "object.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+void object_record(const INST *i,TRACE_RECORD *r) {
+	r->opcode=(uint8_t)i->opcode;
+	r->types=TRACE_TYPES(i->op1_type,i->op2_type,i->op3_type);
+	r->flags=0;
+	r->reserved=0;
+	r->value[0]=i->op1_value;
+	r->value[1]=i->op2_value;
+	r->value[2]=i->op3_value;
+}
+
+void object_inst(const TRACE_RECORD *r,INST *i) {
+	i->opcode=(enum code)r->opcode;
+	i->op1_type=TRACE_TYPE(r->types,0);
+	i->op2_type=TRACE_TYPE(r->types,1);
+	i->op3_type=TRACE_TYPE(r->types,2);
+	i->op1_value=r->value[0];
+	i->op2_value=r->value[1];
+	i->op3_value=r->value[2];
+}
+
+int object_write(FILE *f,const INST *prog,int n,int memsize) {
+	TRACE_HEADER h={{'S','I','M','O'},OBJECT_VERSION,REG_COUNT,(uint32_t)memsize,(uint64_t)n,sizeof(TRACE_RECORD),0};
+	TRACE_RECORD block[4096];
+	int i,k=0,ok;
+	ok=fwrite(&h,sizeof(h),1,f)==1;
+	for(i=0;i!=n&&ok;++i) {
+		object_record(&prog[i],&block[k++]);
+		if(k==4096||i==n-1) {
+			ok=fwrite(block,sizeof(TRACE_RECORD),k,f)==(size_t)k;
+			k=0;
+		}
+	}
+	return ok;
+}
+
+/// whether the operand is one the decoder accepts, registers and addresses in range
+static int object_operand(enum op_type t,int v,int memsize) {
+	switch(t) {
+	case REG:  return v>=0&&v<REG_COUNT;
+	case ADDR: return v>=0&&v%4==0&&v/4<memsize;
+	default:   return 1;
+	}
+}
+
+/// what the text decoder would reject in `i`, NULL when it is well-formed
+static const char *object_check(const INST *i,int memsize) {
+	if(i->opcode>XOR)
+		return "unknown opcode";
+	if(!object_operand(i->op1_type,i->op1_value,memsize)
+		||!object_operand(i->op2_type,i->op2_value,memsize)
+		||!object_operand(i->op3_type,i->op3_value,memsize))
+		return "register or address out of range";
+	switch(i->opcode) {
+	case EXIT:
+		return i->op1_type==CONST&&(i->op1_value==0||i->op1_value==1)?NULL:"op1 of EXIT is constant 1 or 0";
+	case MOV:
+		if(i->op3_type!=NONE||i->op2_type==NONE)
+			return "MOV takes two operands";
+		if(i->op1_type==ADDR)
+			return i->op2_type==REG?NULL:"At MOV, when op1 is ADDR, op2 is only REG";
+		return i->op1_type==REG?NULL:"op1 of MOV is REG or ADDR";
+	default:
+		if(i->op1_type!=REG||i->op2_type==NONE)
+			return "op1 of arithmetic is only REG";
+		return i->op3_type==NONE||i->op2_type==REG?NULL:"op2 of 3-address arithmetic is only REG";
+	}
+}
+
+const char *object_read(const void *data,size_t size,INST **prog,int *n,int *memsize) {
+	const TRACE_HEADER *h=(const TRACE_HEADER*)data;
+	const TRACE_RECORD *r=(const TRACE_RECORD*)(h+1);
+	const char *err;
+	uint64_t i;
+	if(size<sizeof(TRACE_HEADER)||memcmp(h->magic,"SIMO",4)!=0)
+		return "not a binary object";
+	if(h->version!=OBJECT_VERSION||h->record_size!=sizeof(TRACE_RECORD))
+		return "unsupported object version";
+	if((size-sizeof(TRACE_HEADER))/sizeof(TRACE_RECORD)<h->count||h->count>0x7fffffff)
+		return "truncated object";
+	/// byte addresses are ints
+	if(h->memsize>0x7fffffff/4)
+		return "memory size out of range";
+	if(h->memsize>(uint32_t)*memsize)
+		*memsize=(int)h->memsize;
+	*prog=(INST*)malloc((h->count?h->count:1)*sizeof(INST));
+	for(i=0;i!=h->count;++i) {
+		object_inst(&r[i],&(*prog)[i]);
+		if((err=object_check(&(*prog)[i],*memsize))!=NULL) {
+			free(*prog);
+			*prog=NULL;
+			return err;
+		}
+		if((*prog)[i].opcode==EXIT) {
+			++i;
+			break;
+		}
+	}
+	*n=(int)i;
+	return NULL;
+}
+
+const void *map_file(const char *path,size_t *size) {
+#ifndef _WIN32
+	struct stat st;
+	void *p;
+	int fd=open(path,O_RDONLY);
+	if(fd<0)
+		return NULL;
+	if(fstat(fd,&st)!=0||st.st_size==0) {
+		close(fd);
+		return NULL;
+	}
+	*size=(size_t)st.st_size;
+	p=mmap(NULL,*size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	return p==MAP_FAILED?NULL:p;
+#else
+	/// no mapping here, read it whole
+	FILE *f=fopen(path,"rb");
+	char *p;
+	long n;
+	if(f==NULL)
+		return NULL;
+	fseek(f,0,SEEK_END);
+	n=ftell(f);
+	fseek(f,0,SEEK_SET);
+	p=(char*)malloc(n>0?n:1);
+	*size=fread(p,1,n>0?n:0,f);
+	fclose(f);
+	return p;
+#endif
+}
+
+void unmap_file(const void *p,size_t size) {
+#ifndef _WIN32
+	munmap((void*)p,size);
+#else
+	(void)size;
+	free((void*)p);
+#endif
+}
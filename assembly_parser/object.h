@@ -0,0 +1,35 @@
+#ifndef __OBJECT__
+#define __OBJECT__
+
+#include <stdio.h>
+#include <stddef.h>
+#include "inst.h"
+#include "trace.h"
+
+/// binary object: the decoded program, written by the compiler's -b<path> and run by the
+/// simulator's -x<path> without parsing, the text format stays the readable one
+/// laid out as a trace, see trace.h: a TRACE_HEADER with magic "SIMO" and version
+/// OBJECT_VERSION, `memsize` the words the program needs, then `count` records of flags 0
+
+#define OBJECT_VERSION 1
+
+/// pack `i` into `r`, flags 0
+void object_record(const INST *i,TRACE_RECORD *r);
+
+/// unpack `r` into `i`
+void object_inst(const TRACE_RECORD *r,INST *i);
+
+/// write the object of the `n` instructions of `prog`, return 0 when it fails
+int object_write(FILE *f,const INST *prog,int n,int memsize);
+
+/// check and unpack the object at `data`, `*prog` is malloc'd with its instructions up to the first EXIT
+/// `*memsize` grows to the words the header asks for
+/// return NULL, or what is wrong with it
+const char *object_read(const void *data,size_t size,INST **prog,int *n,int *memsize);
+
+/// map the whole file read-only, NULL when it cannot be read
+const void *map_file(const char *path,size_t *size);
+
+void unmap_file(const void *p,size_t size);
+
+#endif // __OBJECT__
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "machine.h"
+#include "inst.h"
+#include "analyze.h"
+#include "object.h"
+
+/// reprice: cycles of a binary trace written by the simulator's -w<path> under another
+/// cost table or cache, in one streaming pass over the mapped file
+///
+/// usage: reprice <trace> [KEY=cycles ...] [-c] [-b]
+/// every key defaults to machine.h, so without any the total is the simulator's
+///   MOV ADD SUB MUL DIV AND OR XOR EXIT  the register form of the opcode
+///   MEM        a MOV from or to memory
+///   IMM EXTMEM an extension operand, on top of the register form
+///   -c         model the data cache: SETS WAYS LINE its geometry, HIT MISS its cycles,
+///              MISS is MEM unless given
+///   -b         pricing speed on stderr
+
+typedef struct COSTS {
+	int op[XOR+1];    /// register form of every opcode, op[MOV] a MOV between registers
+	int mem;          /// MOV from or to memory
+	int imm,extmem;   /// extension operands
+	int cache;        /// -c
+	int sets,ways,line;
+	int hit,miss;     /// miss -1 is `mem`
+} COSTS;
+
+/// cycles of `i` without the cache, as cycles() with the costs of `c`
+int price(const COSTS *c,const INST *i) {
+	enum op_type rhs=i->op3_type==NONE?i->op2_type:i->op3_type;
+	switch(i->opcode) {
+	case MOV:  return i->op1_type==ADDR||i->op2_type==ADDR?c->mem:c->op[MOV];
+	case EXIT: return c->op[EXIT];
+	default:   return c->op[i->opcode]+(rhs==CONST?c->imm:rhs==ADDR?c->extmem:0);
+	}
+}
+
+/// set-associative cache of any geometry, LRU replacement, stores allocate
+typedef struct LRU {
+	int sets,ways,line;
+	int tick;
+	int *tag;         /// line held by every way of every set, -1 when empty
+	int *last;        /// tick of its last access
+	long long hits,misses;
+} LRU;
+
+void lru_init(LRU *l,int sets,int ways,int line) {
+	int k;
+	l->sets=sets;
+	l->ways=ways;
+	l->line=line;
+	l->tick=0;
+	l->hits=l->misses=0;
+	l->tag=(int*)malloc(sets*ways*sizeof(int));
+	l->last=(int*)calloc(sets*ways,sizeof(int));
+	for(k=0;k!=sets*ways;++k)
+		l->tag[k]=-1;
+}
+
+/// look `addr` up, load its line over the least recently used way on a miss, return 1 on a hit
+int lru_access(LRU *l,int addr) {
+	int n=addr/l->line,*tag=l->tag+n%l->sets*l->ways,*last=l->last+n%l->sets*l->ways,victim=0,w;
+	++l->tick;
+	for(w=0;w!=l->ways;++w) {
+		if(tag[w]==n) {
+			last[w]=l->tick;
+			++l->hits;
+			return 1;
+		}
+		if(last[w]<last[victim])
+			victim=w;
+	}
+	tag[victim]=n;
+	last[victim]=l->tick;
+	++l->misses;
+	return 0;
+}
+
+/// the field KEY of `c` sets, NULL when there is no such key
+int *cost_field(COSTS *c,const char *key,int len) {
+	static const char *names[]={"MEM","IMM","EXTMEM","SETS","WAYS","LINE","HIT","MISS"};
+	int *fields[]={&c->mem,&c->imm,&c->extmem,&c->sets,&c->ways,&c->line,&c->hit,&c->miss};
+	int k;
+	for(k=0;k<=XOR;++k)
+		if((int)strlen(opcodes[k].name)==len&&memcmp(opcodes[k].name,key,len)==0)
+			return &c->op[k];
+	for(k=0;k!=(int)(sizeof(names)/sizeof(names[0]));++k)
+		if((int)strlen(names[k])==len&&memcmp(names[k],key,len)==0)
+			return fields[k];
+	return NULL;
+}
+
+int main(int argc,char **argv) {
+	COSTS c={{0},CC_MOV_MEM,CC_EXT_IMM,CC_EXT_MEM,0,CACHE_SETS,CACHE_WAYS,CACHE_LINE,CC_CACHE_HIT,-1};
+	const char *path=NULL;
+	const TRACE_HEADER *h;
+	const TRACE_RECORD *rec;
+	long long total=0,count[XOR+1]={0},op_cycles[XOR+1]={0};
+	uint64_t i;
+	int k,bench=0,faults=0,overflows=0;
+	size_t size;
+	LRU cache;
+	clock_t start;
+
+	for(k=MOV;k<=XOR;++k)
+		c.op[k]=opcodes[k].cycles;
+	for(k=1;k!=argc;++k) {
+		const char *eq=strchr(argv[k],'=');
+		int *field;
+		if(strcmp(argv[k],"-c")==0)
+			c.cache=1;
+		else if(strcmp(argv[k],"-b")==0)
+			bench=1;
+		else if(eq) {
+			if((field=cost_field(&c,argv[k],(int)(eq-argv[k])))==NULL) {
+				fprintf(stderr,"unknown cost '%.*s'\n",(int)(eq-argv[k]),argv[k]);
+				return 1;
+			}
+			*field=atoi(eq+1);
+		} else
+			path=argv[k];
+	}
+	if(path==NULL) {
+		fprintf(stderr,"usage: reprice <trace> [KEY=cycles ...] [-c] [-b]\n");
+		return 1;
+	}
+	if(c.miss<0)
+		c.miss=c.mem;
+	if(c.cache&&(c.sets<1||c.ways<1||c.line<4||c.line%4!=0)) {
+		fprintf(stderr,"cache needs SETS and WAYS of at least 1, LINE a multiple of 4\n");
+		return 1;
+	}
+
+	if((h=(const TRACE_HEADER*)map_file(path,&size))==NULL) {
+		fprintf(stderr,"cannot read '%s'\n",path);
+		return 1;
+	}
+	if(size<sizeof(TRACE_HEADER)||memcmp(h->magic,"SIMT",4)!=0||h->version!=TRACE_VERSION
+		||h->record_size!=sizeof(TRACE_RECORD)||(size-sizeof(TRACE_HEADER))/sizeof(TRACE_RECORD)<h->count) {
+		fprintf(stderr,"'%s' is not a version %d trace\n",path,TRACE_VERSION);
+		unmap_file(h,size);
+		return 1;
+	}
+	if(c.cache)
+		lru_init(&cache,c.sets,c.ways,c.line);
+
+	start=clock();
+	rec=(const TRACE_RECORD*)(h+1);
+	for(i=0;i!=h->count;++i) {
+		INST inst;
+		int cc,addr;
+		object_inst(&rec[i],&inst);
+		if(inst.opcode>XOR)
+			continue;
+		cc=price(&c,&inst);
+		if(c.cache&&(addr=mem_addr(&inst))>=0)
+			cc+=(lru_access(&cache,addr)?c.hit:c.miss)-c.mem;
+		total+=cc;
+		++count[inst.opcode];
+		op_cycles[inst.opcode]+=cc;
+		faults+=rec[i].flags&TRACE_FAULT;
+		overflows+=(rec[i].flags&TRACE_OVERFLOW)!=0;
+	}
+	double priced=(double)(clock()-start)/CLOCKS_PER_SEC;
+
+	printf("Instructions %llu\n",(unsigned long long)h->count);
+	printf("Total clock cycles are %lld\n",total);
+	if(c.cache)
+		printf("Cache hits %lld, misses %lld (%d sets, %d ways, %d byte lines)\n",
+			cache.hits,cache.misses,c.sets,c.ways,c.line);
+	if(faults)
+		printf("Divisions by zero %d\n",faults);
+	if(overflows)
+		printf("Division overflows %d\n",overflows);
+	for(k=MOV;k<=XOR;++k)
+		if(count[k])
+			printf("  %-5s %-10lld %lldcc\n",opcodes[k].name,count[k],op_cycles[k]);
+	if(bench)
+		fprintf(stderr,"%llu records: priced in %.3fs (%.1fM records/s)\n",(unsigned long long)h->count,
+			priced,priced>0?h->count/priced/1e6:0);
+	if(c.cache) {
+		free(cache.tag);
+		free(cache.last);
+	}
+	unmap_file(h,size);
+	return 0;
+}
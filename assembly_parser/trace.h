@@ -0,0 +1,39 @@
+#ifndef __TRACE__
+#define __TRACE__
+
+#include <stdint.h>
+
+/// binary execution trace, written by the simulator's -w<path> and read by reprice
+/// a TRACE_HEADER then `count` TRACE_RECORDs in execution order, in native byte order
+/// every record has the same size, so a reader maps the file and indexes it directly
+
+#define TRACE_VERSION 1
+
+typedef struct TRACE_HEADER {
+	char magic[4];        /// "SIMT"
+	uint32_t version;     /// TRACE_VERSION
+	uint32_t reg_count;   /// REG_COUNT of the simulator that wrote it
+	uint32_t memsize;     /// words of memory
+	uint64_t count;       /// records that follow
+	uint32_t record_size; /// sizeof(TRACE_RECORD)
+	uint32_t reserved;
+} TRACE_HEADER;
+
+typedef struct TRACE_RECORD {
+	uint8_t opcode;       /// enum code
+	uint8_t types;        /// enum op_type of the three operands, see TRACE_TYPES
+	uint8_t flags;        /// TRACE_FAULT or TRACE_OVERFLOW
+	uint8_t reserved;
+	int32_t value[3];     /// register number, constant or byte address of every operand
+} TRACE_RECORD;
+
+/// the instruction divided by zero
+#define TRACE_FAULT 1
+/// the instruction divided INT_MIN by -1
+#define TRACE_OVERFLOW 2
+
+/// pack the operand types of an instruction, and unpack the one of operand `k` (0..2)
+#define TRACE_TYPES(t1,t2,t3) ((uint8_t)((t1)|(t2)<<2|(t3)<<4))
+#define TRACE_TYPE(types,k) ((enum op_type)((types)>>2*(k)&3))
+
+#endif // __TRACE__
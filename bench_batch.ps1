@@ -0,0 +1,49 @@
+param (
+    [int]$Instructions = 2000,
+    [int[]]$Images = @(1000, 10000, 100000)
+)
+
+# Batch throughput: one generated program run over many initial memory images with -i<file>
+# -b reports the images per run and the instructions per second of all lanes together on stderr
+
+$benchDirectory = ".\out\bench"
+
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$simulator = Join-Path -Path $benchDirectory -ChildPath "sim.exe"
+& gcc -O2 -o $simulator $SimulatorFiles
+if ($LASTEXITCODE -ne 0) {
+    Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+    Write-Host " Compilation failed." -ForegroundColor Gray
+    exit 1
+}
+
+$arithmetic = "ADD", "SUB", "MUL", "AND", "OR", "XOR", "DIV"
+$random = New-Object System.Random 1
+$asmFile = Join-Path -Path $benchDirectory -ChildPath "batch$Instructions.asm"
+$lines = New-Object System.Collections.Generic.List[string]
+for ($i = 0; $i -lt $Instructions; $i++) {
+    switch ($i % 10) {
+        0 { $lines.Add("MOV r$($random.Next(8)) [$(4 * $random.Next(64))]") }
+        5 { $lines.Add("MOV [$(4 * $random.Next(3, 64))] r$($random.Next(8))") }
+        7 { $lines.Add("MOV r$($random.Next(8)) $($random.Next(100))") }
+        default { $lines.Add("$($arithmetic[$random.Next($arithmetic.Length)]) r$($random.Next(8)) r$($random.Next(8))") }
+    }
+}
+$lines.Add("EXIT 0")
+Set-Content -Path $asmFile -Value $lines
+
+foreach ($n in $Images) {
+    # one image per line, 64 words of memory each
+    $imageFile = Join-Path -Path $benchDirectory -ChildPath "images$n.txt"
+    $images = New-Object System.Collections.Generic.List[string]
+    for ($i = 0; $i -lt $n; $i++) {
+        $images.Add((1..64 | ForEach-Object { $random.Next(-1000, 1000) }) -join " ")
+    }
+    Set-Content -Path $imageFile -Value $images
+
+    $tableFile = Join-Path -Path $benchDirectory -ChildPath "batch$n.txt"
+    $totalTime = Measure-Command { $report = Get-Content $asmFile | & $simulator -b "-i$imageFile" "-o$tableFile" 2>&1 | Out-String }
+    Write-Host ("{0}, total {1:N0} ms" -f $report.Trim(), $totalTime.TotalMilliseconds)
+}
@@ -0,0 +1,44 @@
+param (
+    [int]$Lines = 1000000,
+    [int]$Runs = 5
+)
+
+# Decoder throughput on every operand form of the text format: registers, constants,
+# addresses, commas, the 3-address form and the ISA extensions
+# -b reports the decode time and MB/s on stderr, -t0 keeps the trace out of the measurement
+
+$benchDirectory = ".\out\bench"
+
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$simulator = Join-Path -Path $benchDirectory -ChildPath "sim.exe"
+& gcc -O2 -o $simulator $SimulatorFiles
+if ($LASTEXITCODE -ne 0) {
+    Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+    Write-Host " Compilation failed." -ForegroundColor Gray
+    exit 1
+}
+
+$forms = @(
+    { param($r) "MOV r$($r.Next(8)) [$(4 * $r.Next(64))]" },
+    { param($r) "MOV [$(4 * $r.Next(3, 64))], r$($r.Next(8))" },
+    { param($r) "MOV r$($r.Next(8)) -$($r.Next(100000))" },
+    { param($r) "ADD r$($r.Next(8)) r$($r.Next(8))" },
+    { param($r) "SUB r$($r.Next(8)), r$($r.Next(8)), r$($r.Next(8))" },
+    { param($r) "MUL r$($r.Next(8)) $($r.Next(1000))" },
+    { param($r) "XOR r$($r.Next(8)) [$(4 * $r.Next(64))]" }
+)
+$random = New-Object System.Random 1
+$asmFile = Join-Path -Path $benchDirectory -ChildPath "decode$Lines.asm"
+$text = New-Object System.Collections.Generic.List[string]
+for ($i = 0; $i -lt $Lines; $i++) {
+    $text.Add((& $forms[$i % $forms.Length] $random))
+}
+$text.Add("EXIT 0")
+Set-Content -Path $asmFile -Value $text
+
+for ($run = 1; $run -le $Runs; $run++) {
+    $report = Get-Content $asmFile -Raw | & $simulator -b -t0 -o- 2>&1 | Select-String 'decoded'
+    Write-Host ("run {0}: {1}" -f $run, $report)
+}
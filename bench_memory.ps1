@@ -0,0 +1,51 @@
+param (
+    [int[]]$Variables = @(1000, 10000, 20000)
+)
+
+# Compile and simulate generated programs using thousands of variables, end to end
+# compiler and simulator both get -m<words>, enough for the variables and the spill slots
+# then again through a binary object, compiler -b<file> and simulator -x<file>
+
+$benchDirectory = ".\out\bench"
+
+$CompilerFiles = "./calculator_recursion/lex.c", "./calculator_recursion/parser.c", "./calculator_recursion/ir.c", "./calculator_recursion/regAlloc.c", "./calculator_recursion/peephole.c", "./calculator_recursion/instSelect.c", "./calculator_recursion/schedule.c", "./calculator_recursion/layout.c", "./calculator_recursion/codeGen.c", "./calculator_recursion/main.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$compiler = Join-Path -Path $benchDirectory -ChildPath "app.exe"
+$simulator = Join-Path -Path $benchDirectory -ChildPath "sim.exe"
+& gcc -O2 -o $compiler $CompilerFiles
+& gcc -O2 -o $simulator $SimulatorFiles
+if ($LASTEXITCODE -ne 0) {
+    Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+    Write-Host " Compilation failed." -ForegroundColor Gray
+    exit 1
+}
+
+foreach ($n in $Variables) {
+    # v_i reads its predecessor and a variable defined long before, so the accesses spread over all of memory
+    $inputFile = Join-Path -Path $benchDirectory -ChildPath "vars$n.in"
+    $asmFile = Join-Path -Path $benchDirectory -ChildPath "vars$n.asm"
+    $lines = New-Object System.Collections.Generic.List[string]
+    $lines.Add("v0 = x + y")
+    for ($i = 1; $i -lt $n; $i++) {
+        $lines.Add("v$i = v$($i - 1) + v$([math]::Floor($i / 2)) * $($i % 7 + 1) - z")
+    }
+    $lines.Add("z = v$($n - 1) + v$([math]::Floor($n / 3))")
+    $lines.Add("y = v$([math]::Floor($n / 2))")
+    Set-Content -Path $inputFile -Value $lines
+
+    $words = $n + 64
+    $compileTime = Measure-Command { Get-Content $inputFile | & $compiler "-m$words" > $asmFile }
+    # the simulator writes its trace to output.txt in the working directory
+    $simulateTime = Measure-Command { Get-Content $asmFile | & $simulator "-m$words" 1 2 3 | Out-Null }
+    $cycles = Get-Content "output.txt" | Select-String 'Total clock cycles are (\d+)' | ForEach-Object { $_.Matches[0].Groups[1].Value }
+    Write-Host ("{0,6} variables: compile {1,8:N0} ms, simulate {2,8:N0} ms, {3,12} cycles" -f $n, $compileTime.TotalMilliseconds, $simulateTime.TotalMilliseconds, $cycles)
+
+    # the same through a binary object: no text to print or parse, the header carries the memory size
+    $objectFile = Join-Path -Path $benchDirectory -ChildPath "vars$n.obj"
+    $compileTime = Measure-Command { Get-Content $inputFile | & $compiler "-m$words" "-b$objectFile" }
+    $simulateTime = Measure-Command { & $simulator "-x$objectFile" 1 2 3 | Out-Null }
+    $cycles = Get-Content "output.txt" | Select-String 'Total clock cycles are (\d+)' | ForEach-Object { $_.Matches[0].Groups[1].Value }
+    Write-Host ("{0,6} variables: compile {1,8:N0} ms, simulate {2,8:N0} ms, {3,12} cycles (object)" -f $n, $compileTime.TotalMilliseconds, $simulateTime.TotalMilliseconds, $cycles)
+}
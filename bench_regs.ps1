@@ -0,0 +1,44 @@
+param (
+    [int[]]$RegCounts = @(4, 8, 16, 32)
+)
+
+# Sweep the register file size over the inputs in .\out\inputs
+# compiler and simulator are rebuilt with the same -DREG_COUNT for every size
+
+$inputDirectory = ".\out\inputs"
+$benchDirectory = ".\out\bench"
+
+$CompilerFiles = "./calculator_recursion/lex.c", "./calculator_recursion/parser.c", "./calculator_recursion/ir.c", "./calculator_recursion/regAlloc.c", "./calculator_recursion/peephole.c", "./calculator_recursion/instSelect.c", "./calculator_recursion/schedule.c", "./calculator_recursion/layout.c", "./calculator_recursion/codeGen.c", "./calculator_recursion/main.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$inputFiles = Get-ChildItem -Path $inputDirectory -Filter "*.in" -File
+
+foreach ($n in $RegCounts) {
+    $compiler = Join-Path -Path $benchDirectory -ChildPath "app$n.exe"
+    $simulator = Join-Path -Path $benchDirectory -ChildPath "sim$n.exe"
+    & gcc -O2 "-DREG_COUNT=$n" -o $compiler $CompilerFiles
+    & gcc -O2 "-DREG_COUNT=$n" -o $simulator $SimulatorFiles
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+        Write-Host " Compilation failed with $n registers." -ForegroundColor Gray
+        exit 1
+    }
+
+    $spillCycles = 0
+    $totalCycles = 0
+    foreach ($file in $inputFiles) {
+        $asmFile = Join-Path -Path $benchDirectory -ChildPath ($file.Name -replace '\.in$', ".r$n.asm")
+        $reportFile = Join-Path -Path $benchDirectory -ChildPath ($file.Name -replace '\.in$', ".r$n.report")
+        Get-Content $file.FullName | & $compiler -r > $asmFile 2> $reportFile
+        Get-Content $reportFile | Select-String 'spill total: (\d+)cc' | ForEach-Object {
+            $spillCycles += [int]$_.Matches[0].Groups[1].Value
+        }
+        # the simulator writes its trace to output.txt in the working directory
+        Get-Content $asmFile | & $simulator | Out-Null
+        Get-Content "output.txt" | Select-String 'Total clock cycles are (\d+)' | ForEach-Object {
+            $totalCycles += [long]$_.Matches[0].Groups[1].Value
+        }
+    }
+    Write-Host ("{0,2} registers: {1,12} spill cycles, {2,12} total cycles" -f $n, $spillCycles, $totalCycles)
+}
@@ -0,0 +1,49 @@
+param (
+    [int]$Instructions = 1000000
+)
+
+# Re-pricing a binary trace: the simulator writes it once with -w<file>, reprice then prices it
+# under other cost tables and caches without running the program again
+# -b reports the records priced per second on stderr
+
+$benchDirectory = ".\out\bench"
+
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+$RepriceFiles = "./assembly_parser/reprice.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$simulator = Join-Path -Path $benchDirectory -ChildPath "sim.exe"
+$reprice = Join-Path -Path $benchDirectory -ChildPath "reprice.exe"
+& gcc -O2 -o $simulator $SimulatorFiles
+& gcc -O2 -o $reprice $RepriceFiles
+if ($LASTEXITCODE -ne 0) {
+    Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+    Write-Host " Compilation failed." -ForegroundColor Gray
+    exit 1
+}
+
+$arithmetic = "ADD", "SUB", "MUL", "AND", "OR", "XOR", "DIV"
+$random = New-Object System.Random 1
+$asmFile = Join-Path -Path $benchDirectory -ChildPath "reprice$Instructions.asm"
+$lines = New-Object System.Collections.Generic.List[string]
+for ($i = 0; $i -lt $Instructions; $i++) {
+    switch ($i % 10) {
+        0 { $lines.Add("MOV r$($random.Next(8)) [$(4 * $random.Next(64))]") }
+        5 { $lines.Add("MOV [$(4 * $random.Next(3, 64))] r$($random.Next(8))") }
+        7 { $lines.Add("MOV r$($random.Next(8)) $($random.Next(100))") }
+        default { $lines.Add("$($arithmetic[$random.Next($arithmetic.Length)]) r$($random.Next(8)) r$($random.Next(8))") }
+    }
+}
+$lines.Add("EXIT 0")
+Set-Content -Path $asmFile -Value $lines
+
+$traceFile = Join-Path -Path $benchDirectory -ChildPath "reprice$Instructions.trace"
+$simulateTime = Measure-Command { Get-Content $asmFile | & $simulator -t0 -o- "-w$traceFile" | Out-Null }
+Write-Host ("simulate and write the trace: {0:N0} ms" -f $simulateTime.TotalMilliseconds)
+
+# machine.h, then cheaper multiplication, slower memory, and a larger cache
+foreach ($costs in @(), @("MUL=20"), @("MEM=100"), @("-c"), @("-c", "SETS=16", "WAYS=4", "LINE=32")) {
+    $totalTime = Measure-Command { $report = & $reprice $traceFile -b @costs 2>&1 | Out-String }
+    $cycles = $report | Select-String 'Total clock cycles are (\d+)' | ForEach-Object { $_.Matches[0].Groups[1].Value }
+    Write-Host ("{0,-30} {1,12} cycles, total {2:N0} ms" -f ($costs -join ' '), $cycles, $totalTime.TotalMilliseconds)
+}
@@ -0,0 +1,44 @@
+param (
+    [int[]]$Instructions = @(1000000, 4000000)
+)
+
+# Simulator speed on generated straight-line programs of millions of instructions
+# -b reports decode and execute time, and instructions per second of the execute loop or the JIT, on stderr
+
+$benchDirectory = ".\out\bench"
+
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$simulator = Join-Path -Path $benchDirectory -ChildPath "sim.exe"
+& gcc -O2 -o $simulator $SimulatorFiles
+if ($LASTEXITCODE -ne 0) {
+    Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+    Write-Host " Compilation failed." -ForegroundColor Gray
+    exit 1
+}
+
+$arithmetic = "ADD", "SUB", "MUL", "AND", "OR", "XOR", "DIV"
+$random = New-Object System.Random 1
+foreach ($n in $Instructions) {
+    # one load, one store and one constant every ten instructions, arithmetic between registers otherwise
+    $asmFile = Join-Path -Path $benchDirectory -ChildPath "sim$n.asm"
+    $lines = New-Object System.Collections.Generic.List[string]
+    for ($i = 0; $i -lt $n; $i++) {
+        switch ($i % 10) {
+            0 { $lines.Add("MOV r$($random.Next(8)) [$(4 * $random.Next(64))]") }
+            5 { $lines.Add("MOV [$(4 * $random.Next(3, 64))] r$($random.Next(8))") }
+            7 { $lines.Add("MOV r$($random.Next(8)) $($random.Next(100))") }
+            default { $lines.Add("$($arithmetic[$random.Next($arithmetic.Length)]) r$($random.Next(8)) r$($random.Next(8))") }
+        }
+    }
+    $lines.Add("EXIT 0")
+    Set-Content -Path $asmFile -Value $lines
+
+    # -t0 only reports the result, -t1 also writes the trace of every instruction, -j runs native code
+    foreach ($mode in @("-t0"), @("-t1"), @("-t0", "-j")) {
+        $traceFile = Join-Path -Path $benchDirectory -ChildPath "sim$n$($mode -join '').txt"
+        $totalTime = Measure-Command { $report = Get-Content $asmFile | & $simulator -b @mode "-o$traceFile" 2>&1 | Out-String }
+        Write-Host ("{0}: {1} total {2:N0} ms" -f ($mode -join ' '), ($report.Trim() -replace '\s*\r?\n\s*', ', '), $totalTime.TotalMilliseconds)
+    }
+}
@@ -0,0 +1,43 @@
+param (
+    # compiler options to compare, one run per entry
+    [string[]]$Variants = @("-t2", "-t3", "-xi", "-xm", "-xi -xm", "-t3 -xi -xm")
+)
+
+# Compare target formats and ISA extensions over the inputs in .\out\inputs
+# reports the instructions emitted and the cycles the simulator charges
+
+$inputDirectory = ".\out\inputs"
+$benchDirectory = ".\out\bench"
+
+$CompilerFiles = "./calculator_recursion/lex.c", "./calculator_recursion/parser.c", "./calculator_recursion/ir.c", "./calculator_recursion/regAlloc.c", "./calculator_recursion/peephole.c", "./calculator_recursion/instSelect.c", "./calculator_recursion/schedule.c", "./calculator_recursion/layout.c", "./calculator_recursion/codeGen.c", "./calculator_recursion/main.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+$SimulatorFiles = "./assembly_parser/main.c", "./assembly_parser/execute.c", "./assembly_parser/inst.c", "./assembly_parser/analyze.c", "./assembly_parser/object.c"
+
+New-Item -ItemType Directory -Force -Path $benchDirectory | Out-Null
+$compiler = Join-Path -Path $benchDirectory -ChildPath "app.exe"
+$simulator = Join-Path -Path $benchDirectory -ChildPath "sim.exe"
+& gcc -O2 -o $compiler $CompilerFiles
+& gcc -O2 -o $simulator $SimulatorFiles
+if ($LASTEXITCODE -ne 0) {
+    Write-Host "[ Error ]:" -ForegroundColor Red -NoNewline
+    Write-Host " Compilation failed." -ForegroundColor Gray
+    exit 1
+}
+
+$inputFiles = Get-ChildItem -Path $inputDirectory -Filter "*.in" -File
+foreach ($variant in $Variants) {
+    $options = $variant -split ' ' | Where-Object { $_ }
+    $tag = ($options -join '') -replace '-', '_'
+    $instructions = 0
+    $totalCycles = 0
+    foreach ($file in $inputFiles) {
+        $asmFile = Join-Path -Path $benchDirectory -ChildPath ($file.Name -replace '\.in$', "$tag.asm")
+        Get-Content $file.FullName | & $compiler @options > $asmFile
+        $instructions += (Get-Content $asmFile | Measure-Object -Line).Lines
+        # the simulator writes its trace to output.txt in the working directory
+        Get-Content $asmFile | & $simulator | Out-Null
+        Get-Content "output.txt" | Select-String 'Total clock cycles are (\d+)' | ForEach-Object {
+            $totalCycles += [long]$_.Matches[0].Groups[1].Value
+        }
+    }
+    Write-Host ("{0,-14} {1,10} instructions, {2,12} cycles" -f $variant, $instructions, $totalCycles)
+}
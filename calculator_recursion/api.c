@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "api.h"
+#include "lex.h"
+#include "parser.h"
+#include "codeGen.h"
+#include "ir.h"
+#include "../assembly_parser/analyze.h"
+#include "../assembly_parser/execute.h"
+
+#ifdef _WIN32
+#include <windows.h>
+static SRWLOCK compile_lock = SRWLOCK_INIT;
+#define calc_lock() AcquireSRWLockExclusive(&compile_lock)
+#define calc_unlock() ReleaseSRWLockExclusive(&compile_lock)
+#else
+#include <pthread.h>
+static pthread_mutex_t compile_lock = PTHREAD_MUTEX_INITIALIZER;
+#define calc_lock() pthread_mutex_lock(&compile_lock)
+#define calc_unlock() pthread_mutex_unlock(&compile_lock)
+#endif
+
+// faults of programs up to this size are kept on the stack of `calc_run()`
+#define FAULT_STACK 4096
+
+struct CalcProgram {
+    OP* op;            // `n + 1`, the last one an EXIT like the simulator appends
+    int n;
+    int words;
+    long long cycles;
+    int pipelined;
+    int cache_hits;
+    int cache_misses;
+};
+
+const CalcOptions calc_defaults = { 1, 2, 0, 0, 0, MEMSIZE };
+
+/**
+ * Parse and generate the whole input, as `main()` does
+ * an error() longjmp()s back here, the partial trees of that statement are freed
+ * @returns `0` when not even the statements before the error make a program
+ */
+static int calc_parse(void) {
+    jmp_buf abort;
+
+    if (setjmp(abort) != 0) {
+        // what `emit_error_exit()` writes for the command line
+        compile_abort = NULL;
+        freeLiveNodes();
+        return generate_error_exit();
+    }
+    compile_abort = &abort;
+    initTable();
+    generate_prologue();
+    while (statement())
+        ;
+    compile_abort = NULL;
+    return 1;
+}
+
+/**
+ * Run the compiler over `source` with `options`
+ * the caller holds `compile_lock`
+ *
+ * @param source
+ * @param len
+ * @param options
+ * @param n instructions of the program
+ * @returns the program after `generate_epilogue()` or `generate_error_exit()`, malloc'd, `NULL` when there is none
+ */
+static INST* calc_generate(const char* source, int len, const CalcOptions* options, int* n) {
+    INST* inst = NULL;
+
+    opt_report = 0;
+    opt_level = options->level;
+    ir_target = options->target == 3 ? TARGET_3ADDR : TARGET_2ADDR;
+    ir_extensions = options->extensions;
+    opt_issue_width = options->issue_width;
+    opt_cache = options->cache;
+    opt_object = NULL;
+    opt_line_map = NULL;
+    mem_words = options->words > 0 ? options->words : MEMSIZE;
+    lex_source(source, len);
+    if (calc_parse()) {
+        inst = ir_instructions(&ir_program);
+        *n = ir_program.size;
+    }
+    lex_source(NULL, 0);
+    return inst;
+}
+
+CalcProgram* calc_compile(const char* source, int len, const CalcOptions* options) {
+    CalcProgram* prog = (CalcProgram*)malloc(sizeof(CalcProgram));
+    ANALYSIS a;
+    INST* inst;
+    int n = 0;
+
+    if (!prog)
+        return NULL;
+    if (!options)
+        options = &calc_defaults;
+    calc_lock();
+    inst = calc_generate(source, len, options, &n);
+    calc_unlock();
+    if (!inst) {
+        inst = (INST*)malloc(sizeof(INST));
+        if (inst)
+            *inst = (INST){ EXIT, CONST, 1, NONE, 0, NONE, 0 };
+        n = 1;
+    }
+    prog->n = n;
+    prog->words = options->words > 0 ? options->words : MEMSIZE;
+    prog->op = (OP*)malloc((n + 1) * sizeof(OP));
+    if (!inst || !prog->op) {
+        free(inst);
+        calc_free(prog);
+        return NULL;
+    }
+
+    // straight-line, so the simulator's timing is known before running
+    analyze_init(&a, options->issue_width, options->cache, prog->words);
+    for (int i = 0; i < n; i++) {
+        prog->op[i] = lower(&inst[i]);
+        analyze_inst(&a, &inst[i]);
+    }
+    prog->op[n] = (OP){ H_EXIT, 0, 0, 0 };
+    prog->cycles = a.cycles;
+    prog->pipelined = options->issue_width > 0 ? a.pipe.finish : 0;
+    prog->cache_hits = a.cache.hits;
+    prog->cache_misses = a.cache.misses;
+    analyze_free(&a);
+    free(inst);
+    return prog;
+}
+
+int calc_words(const CalcProgram* prog) {
+    return prog->words;
+}
+
+void calc_run(const CalcProgram* prog, int* mem, CalcResult* result) {
+    char stack[FAULT_STACK];
+    char* fault = prog->n < FAULT_STACK ? stack : (char*)malloc(prog->n + 1);
+    int exit_at;
+
+    memset(fault, 0, prog->n + 1);
+    memset(result->r, 0, sizeof(result->r));
+    exit_at = execute(prog->op, result->r, mem, fault);
+    result->status = prog->op[exit_at].d;
+    result->faults = 0;
+    for (int i = 0; i < exit_at; i++)
+        result->faults += fault[i] != 0;
+    result->cycles = prog->cycles;
+    result->pipelined = prog->pipelined;
+    result->cache_hits = prog->cache_hits;
+    result->cache_misses = prog->cache_misses;
+    if (fault != stack)
+        free(fault);
+}
+
+void calc_free(CalcProgram* prog) {
+    if (!prog)
+        return;
+    free(prog->op);
+    free(prog);
+}
+
+int calc_compile_and_run(const char* source, int len, const CalcOptions* options, int* mem, CalcResult* result) {
+    CalcProgram* prog = calc_compile(source, len, options);
+    if (!prog)
+        return 0;
+    calc_run(prog, mem, result);
+    calc_free(prog);
+    return 1;
+}
@@ -0,0 +1,102 @@
+#ifndef __API__
+#define __API__
+
+#include "../assembly_parser/machine.h"
+
+/**
+ * Compile and run in process, without the text between the compiler and the simulator
+ * thread-safe, compiles serialized: the lexer, the symbol table and the IR buffer of the
+ * compiler are globals, so `calc_compile()` holds a lock while it runs; a compile is short
+ * next to the runs of the program it serves, and those are not serialized, a compiled
+ * program is read-only and `calc_run()` may run it from any number of threads at once
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The command line options of the compiler that change the program
+ * @struct
+ */
+typedef struct {
+    int level;       // -O<n>
+    int target;      // -t2 / -t3, `2` or `3` address arithmetic
+    int extensions;  // -xi / -xm, `IR_EXT_IMM | IR_EXT_MEM` of ir.h
+    int issue_width; // -p<w>, also the pipelined timing of the result, `0` for none
+    int cache;       // -c, also the data cache of the result
+    int words;       // -m<words>, `0` for `MEMSIZE`
+} CalcOptions;
+
+/**
+ * A compiled program, lowered for the simulator's execute loop
+ * @struct
+ */
+typedef struct CalcProgram CalcProgram;
+
+/**
+ * The state of the machine after a run and what the simulator would report for it
+ * @struct
+ */
+typedef struct {
+    int status;        // operand of the EXIT, `1` when the source did not compile
+    int r[REG_COUNT];
+    int faults;        // DIVs by zero or of INT_MIN by -1, each kept its dividend
+    long long cycles;  // "Total clock cycles"
+    int pipelined;     // "Pipelined clock cycles", `0` without `issue_width`
+    int cache_hits;
+    int cache_misses;
+} CalcResult;
+
+/**
+ * The defaults of the command line: `-O1`, 2-address, no extension, no pipeline, no cache
+ */
+extern const CalcOptions calc_defaults;
+
+/**
+ * Compile `len` bytes of `source`
+ * a source the command line compiler rejects becomes the same program, its statements
+ * up to the error then `EXIT 1`
+ * thread-safe, one compile at a time
+ *
+ * @param source statements, one per line
+ * @param len
+ * @param options `NULL` for `calc_defaults`
+ * @returns release it with `calc_free()`, `NULL` when out of memory
+ */
+extern CalcProgram* calc_compile(const char* source, int len, const CalcOptions* options);
+
+/**
+ * Words of memory `calc_run()` needs
+ * @param prog
+ */
+extern int calc_words(const CalcProgram* prog);
+
+/**
+ * Run `prog` from zeroed registers
+ * reentrant, the program is not modified
+ *
+ * @param prog
+ * @param mem `calc_words(prog)` words, `x/y/z` in the first three, updated in place
+ * @param result
+ */
+extern void calc_run(const CalcProgram* prog, int* mem, CalcResult* result);
+
+extern void calc_free(CalcProgram* prog);
+
+/**
+ * `calc_compile()`, `calc_run()` and `calc_free()` in one call
+ * @param source
+ * @param len
+ * @param options `NULL` for `calc_defaults`
+ * @param mem see `calc_run()`, at least `options->words` words
+ * @param result
+ * @returns `0` when out of memory
+ */
+extern int calc_compile_and_run(const char* source, int len, const CalcOptions* options, int* mem, CalcResult* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __API__
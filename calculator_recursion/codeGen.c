@@ -1,30 +1,133 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "codeGen.h"
+#include "ir.h"
+#include "regAlloc.h"
+#include "peephole.h"
+#include "instSelect.h"
+#include "schedule.h"
+#include "layout.h"
 
-static int reg_label = 0;
-static int mem_label = 63;
+#define CC_INFINITY (INT_MAX / 4)
+// strength reduction never needs more steps, `|c| <= 2^31`
+#define REDUCE_MAX_STEPS 66
 
 /**
- * Write a register registration on stdin and return the allocated rege label
+ * In which order `asm_arithmetic` evaluates a node with `k` free registers
+ * operands go to vregs, so no plan emits a store: where to spill, and whether to at all,
+ * is decided by `reg_alloc()`; the labelling only orders the operands and prices
+ * the spill `reg_alloc()` will likely need, see `asm_label_spill()`
+ * @enum
+ */
+typedef enum asm_plan_t {
+    PLAN_LEFT_FIRST,  // left with `k`, right with `k - 1`
+    PLAN_RIGHT_FIRST, // right with `k`, left with `k - 1`
+    PLAN_SPILL_LEFT,  // left first, right planned with all `k`, left expected to be spilled around it
+    PLAN_SPILL_RIGHT, // right first, left planned with all `k`, right expected to be spilled around it
+    PLAN_BORROW,      // `k == 1`, an ancestor's register is spilled, evaluate with 2
+    PLAN_REDUCE       // strength reduced by `asm_reduce()`, only the non-constant operand is evaluated
+} AsmPlan;
+
+/**
+ * One step of a multiplication of `x` by a constant, applied to a copy `t`
+ * @enum
+ */
+typedef enum asm_reduce_step_t {
+    REDUCE_DOUBLE, // ADD t t
+    REDUCE_ADD,    // ADD t x
+    REDUCE_SUB,    // SUB t x
+    REDUCE_NEGATE  // t = 0 - t
+} AsmReduceStep;
+
+/**
+ * Cheaper replacement of a `MUL` or `DIV` by a constant, chosen by `asm_reduce()`
+ * @struct
+ */
+typedef struct {
+    BTNode* operand;  // evaluated first, `NULL` when the result does not need it
+    int is_constant;  // the result is `constant`, `operand` is only evaluated for its `=`
+    int constant;
+    int count;        // steps on a copy of `operand`, none: the result is `operand` itself
+    AsmReduceStep step[REDUCE_MAX_STEPS];
+    int cycles;       // cycles of the steps, looked up in `opcodes`
+} AsmReduction;
+
+int opt_report = 0;
+int opt_level = 1;
+int opt_issue_width = 0;
+int opt_cache = 0;
+const char* opt_object = NULL;
+const char* opt_line_map = NULL;
+
+static int stmt_label = 0;
+/**
+ * Set once the passes run over the whole program, an error from then on has nothing left to flush
+ */
+static int asm_finishing = 0;
+/**
+ * Input line of every statement label, `0` for the epilogue
+ */
+static int* stmt_line = NULL;
+/**
+ * vreg holding the current value of each variable, across statements
+ * grown to `sbcount` before every statement
+ */
+static int* var_vreg = NULL;
+static int var_vreg_size = 0;
+
+/**
+ * Label every node with `cost[k]` / `plan[k]` for `k = 1..REG_COUNT` (Aho-Johnson)
+ * 
+ * @param root 
+ */
+static void asm_label(BTNode* root);
+/**
+ * Whether `root` assigns the variable at `addr`, needs `asm_label()` first
+ * 
+ * @param root 
+ * @param addr 
+ */
+static int asm_writes(BTNode* root, int addr);
+/**
+ * Whether `root` is a `*` or `/` with a cheaper form than `MOV c; MUL`
+ * multipliers become add/sub chains, `x / 1`, `x / -1` and `x / x` (`x` provably
+ * non-zero and without `=`) need no `DIV`
+ * 
+ * @param root 
+ * @param reduction filled when it returns `1`
+ */
+static int asm_reduce(BTNode* root, AsmReduction* reduction);
+/**
+ * Emit a register registration, a variable already held by a vreg is reused
  * 
  * @param node 
  */
 static void asm_ralloc(BTNode* node);
 /**
- * Write a assign asm statement on stdin by a valid tree
+ * Emit a assign asm statement by a valid tree
  * the tree should have `=` rooted
  * 
  * @param assign_root 
+ * @param k 
  */
-static void asm_assign(BTNode* assign_root);
+static void asm_assign(BTNode* assign_root, int k);
 /**
- * Write a arithmetic asm statement on stdin by valid arthmetic tree
+ * Emit a arithmetic asm statement by valid arthmetic tree
+ * follow `arith_root->plan[k]` chosen by `asm_label()`
  * 
  * @param arith_root 
+ * @param k 
+ */
+static void asm_arithmetic(BTNode* arith_root, int k);
+/**
+ * Emit the sequence `asm_reduce()` chose for `root`
+ * 
+ * @param root 
+ * @param k 
  */
-static void asm_arithmetic(BTNode* arith_root);
+static void asm_reduce_emit(BTNode* root, int k);
 /**
  * Write the overall asm generating logic
  * if is a node:
@@ -33,107 +136,353 @@ static void asm_arithmetic(BTNode* arith_root);
  *   call `asm_arithmetic()`
  * else:
  *   call `asm_assign()`
- * return the last reg label in the tree, if is `NO_REG_LABEL` then the asm does not generated
+ * the vreg holding the value of the tree is left in `root->reg`
  * 
  * @param root 
+ * @param k registers expected to be free, only steers the evaluation order
  */
-static void asm_generate(BTNode* root);
+static void asm_generate(BTNode* root, int k);
 
-static void asm_ralloc(BTNode* node) {
-    switch (node->data) {
-    case ID:
-        fprintf(stdout, "MOV r%d [%d]\n", reg_label, get_addr(node->lexeme));
-        break;
-    case INT:
-        fprintf(stdout, "MOV r%d %s\n", reg_label, node->lexeme);
-        break;
+static IROpcode asm_opcode(char op) {
+    switch (op) {
+    case '+':
+        return IR_ADD;
+    case '-':
+        return IR_SUB;
+    case '*':
+        return IR_MUL;
+    case '/':
+        return IR_DIV;
+    case '|':
+        return IR_OR;
+    case '^':
+        return IR_XOR;
     default:
-        return;
+        return IR_AND;
     }
-    node->reg = reg_label++;
 }
 
-static void asm_assign(BTNode* assign_root) {
-    asm_generate(assign_root->right);
-    fprintf(stdout, "MOV [%d] r%d\n", get_addr(assign_root->left->lexeme), assign_root->right->reg);
-    assign_root->reg = assign_root->right->reg;
+static int op_cycles(char op) {
+    return opcodes[asm_opcode(op)].cycles;
 }
 
-static int max(int a, int b) {
-    return a > b ? a : b;
+static int asm_reduce_cost(const AsmReduceStep* step, int count) {
+    int cycles = 0;
+    for (int i = 0; i < count; i++)
+        switch (step[i]) {
+        case REDUCE_DOUBLE:
+        case REDUCE_ADD:
+            cycles += opcodes[IR_ADD].cycles;
+            break;
+        case REDUCE_SUB:
+            cycles += opcodes[IR_SUB].cycles;
+            break;
+        case REDUCE_NEGATE:
+            cycles += opcodes[IR_MOV].cycles + opcodes[IR_SUB].cycles;
+            break;
+        }
+    return cycles;
 }
 
-static int get_depth(BTNode* root) {
-    return !root
-        ? 0
-        : root->data == ASSIGN
-        ? get_depth(root->right)
-        : 1 + max(get_depth(root->left), get_depth(root->right));
-}
+/**
+ * Cheapest add/sub chain multiplying by `c`, binary and non-adjacent form are tried
+ * 
+ * @param c 
+ * @param reduction 
+ */
+static void asm_reduce_chain(int c, AsmReduction* reduction) {
+    unsigned long long m = c < 0 ? -(long long)c : c;
+    AsmReduceStep step[REDUCE_MAX_STEPS];
+    int count = 0;
 
-#define MIN(a, b) (a < b ? a : b)
-#define MAX(a, b) (a > b ? a : b)
-static void asm_arithmetic(BTNode* arith_root) {
-    int release_register = reg_label == 7;
-    if (release_register) {
-        fprintf(stdout, "MOV [%d] r6\n", mem_label * 4);
-        reg_label--;
-        mem_label--;
+    // binary: double for every bit below the top one, add `x` for the set ones
+    int top = 63;
+    while (!(m >> top & 1))
+        top--;
+    for (int b = top - 1; b >= 0; b--) {
+        step[count++] = REDUCE_DOUBLE;
+        if (m >> b & 1)
+            step[count++] = REDUCE_ADD;
     }
+    if (c < 0)
+        step[count++] = REDUCE_NEGATE;
+    reduction->count = count;
+    memcpy(reduction->step, step, count * sizeof(AsmReduceStep));
+    reduction->cycles = asm_reduce_cost(step, count);
 
-    if (get_depth(arith_root->left) >= get_depth(arith_root->right)) {
-        asm_generate(arith_root->left);
-        asm_generate(arith_root->right);
-    } else {
-        asm_generate(arith_root->right);
-        asm_generate(arith_root->left);
+    // non-adjacent form: digits in {-1, 0, 1}, no two adjacent non-zero ones
+    int digit[REDUCE_MAX_STEPS];
+    int digits = 0;
+    for (unsigned long long n = m; n; n >>= 1)
+        if (n & 1) {
+            digit[digits++] = (n & 3) == 3 ? -1 : 1;
+            n += (n & 3) == 3 ? 1 : -1;
+        } else
+            digit[digits++] = 0;
+    count = 0;
+    for (int d = digits - 2; d >= 0; d--) {
+        step[count++] = REDUCE_DOUBLE;
+        if (digit[d])
+            step[count++] = digit[d] > 0 ? REDUCE_ADD : REDUCE_SUB;
     }
+    if (c < 0)
+        step[count++] = REDUCE_NEGATE;
+    if (asm_reduce_cost(step, count) < reduction->cycles) {
+        reduction->count = count;
+        memcpy(reduction->step, step, count * sizeof(AsmReduceStep));
+        reduction->cycles = asm_reduce_cost(step, count);
+    }
+}
 
-    int small_reg = MIN(arith_root->left->reg, arith_root->right->reg);
-    int large_reg = MAX(arith_root->left->reg, arith_root->right->reg);
+static int asm_nonzero(BTNode* root) {
+    if (root->data == INT)
+        return atoi(root->lexeme) != 0;
+    return root->data == BIT_OR && (asm_nonzero(root->left) || asm_nonzero(root->right));
+}
 
-    int former_reg = release_register ? large_reg : small_reg;
-    int latter_reg = release_register ? small_reg : large_reg;
+static int asm_same(BTNode* a, BTNode* b) {
+    if (!a || !b)
+        return a == b;
+    return a->data == b->data && a->data != ASSIGN && strcmp(a->lexeme, b->lexeme) == 0
+        && asm_same(a->left, b->left) && asm_same(a->right, b->right);
+}
 
-    switch (arith_root->lexeme[0]) {
-    case '+':
-        fprintf(stdout, "ADD r%d r%d\n", former_reg, latter_reg);
+static int asm_reduce(BTNode* root, AsmReduction* reduction) {
+    BTNode* l = root->left;
+    BTNode* r = root->right;
+    memset(reduction, 0, sizeof(AsmReduction));
+    switch (root->lexeme[0]) {
+    case '*': {
+        if ((l->data == INT) == (r->data == INT))
+            return 0;
+        int c = atoi((l->data == INT ? l : r)->lexeme);
+        reduction->operand = l->data == INT ? r : l;
+        if (c == 0) {
+            reduction->is_constant = 1;
+            reduction->cycles = opcodes[IR_MOV].cycles;
+            if (!reduction->operand->mutates)
+                reduction->operand = NULL;
+        } else
+            asm_reduce_chain(c, reduction);
+        // the copy of `x` is needed either way
+        return reduction->cycles < opcodes[IR_MOV].cycles + opcodes[IR_MUL].cycles;
+    }
+    case '/':
+        if (r->data == INT && (atoi(r->lexeme) == 1 || atoi(r->lexeme) == -1)) {
+            reduction->operand = l;
+            if (atoi(r->lexeme) == -1) {
+                reduction->step[reduction->count++] = REDUCE_NEGATE;
+                reduction->cycles = asm_reduce_cost(reduction->step, reduction->count);
+            }
+            return 1;
+        }
+        if (asm_same(l, r) && asm_nonzero(l)) {
+            reduction->is_constant = 1;
+            reduction->constant = 1;
+            reduction->cycles = opcodes[IR_MOV].cycles;
+            return 1;
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Estimated cycles to keep the value of `node` aside while `clobber` is evaluated
+ * mirrors `reg_alloc()`: constants are rematerialized and variables reloaded from home,
+ * only temporaries are stored; nothing here emits the spill
+ * 
+ * @param node 
+ * @param clobber 
+ */
+static int asm_label_spill(BTNode* node, BTNode* clobber) {
+    switch (node->data) {
+    case INT:
+        return CC_MOV_REG;
+    case ID:
+        return asm_writes(clobber, get_addr(node->lexeme)) ? 2 * CC_MOV_MEM : CC_MOV_MEM;
+    case ASSIGN:
+        return asm_writes(clobber, get_addr(node->left->lexeme)) ? 2 * CC_MOV_MEM : CC_MOV_MEM;
+    default:
+        return 2 * CC_MOV_MEM;
+    }
+}
+
+static void asm_label(BTNode* root) {
+    switch (root->data) {
+    case ID:
+    case INT:
+        root->mutates = 0;
+        for (int k = 1; k <= REG_COUNT; k++)
+            root->cost[k] = root->data == ID ? CC_MOV_MEM : CC_MOV_REG;
+        return;
+    case ASSIGN:
+        asm_label(root->right);
+        root->mutates = 1;
+        for (int k = 1; k <= REG_COUNT; k++)
+            root->cost[k] = root->right->cost[k] + CC_MOV_MEM;
+        return;
+    default:
         break;
-    case '-':
-        fprintf(stdout, "SUB r%d r%d\n", arith_root->left->reg, arith_root->right->reg);
-        if (arith_root->left->reg == latter_reg)
-            fprintf(stdout, "MOV r%d r%d\n", former_reg, latter_reg);
+    }
+
+    BTNode* l = root->left;
+    BTNode* r = root->right;
+    asm_label(l);
+    asm_label(r);
+    // with `=` inside, reordering would change which value is read
+    int keep_order = l->mutates || r->mutates;
+    int spill_l = asm_label_spill(l, r);
+    int spill_r = asm_label_spill(r, l);
+    root->mutates = keep_order;
+
+    for (int k = 2; k <= REG_COUNT; k++) {
+        int best = l->cost[k] + r->cost[k - 1];
+        int plan = PLAN_LEFT_FIRST;
+        if (!keep_order && r->cost[k] + l->cost[k - 1] < best) {
+            best = r->cost[k] + l->cost[k - 1];
+            plan = PLAN_RIGHT_FIRST;
+        }
+        if (l->cost[k] + r->cost[k] + spill_l < best) {
+            best = l->cost[k] + r->cost[k] + spill_l;
+            plan = PLAN_SPILL_LEFT;
+        }
+        if (!keep_order && r->cost[k] + l->cost[k] + spill_r < best) {
+            best = r->cost[k] + l->cost[k] + spill_r;
+            plan = PLAN_SPILL_RIGHT;
+        }
+        root->cost[k] = best + op_cycles(root->lexeme[0]);
+        root->plan[k] = plan;
+    }
+    AsmReduction reduction;
+    if (asm_reduce(root, &reduction))
+        for (int k = 2; k <= REG_COUNT; k++) {
+            root->cost[k] = (reduction.operand ? reduction.operand->cost[k] : 0) + reduction.cycles;
+            root->plan[k] = PLAN_REDUCE;
+        }
+    // a binary operation never fits in one register, assume the borrowed one is a temporary
+    root->cost[1] = REG_COUNT > 1 ? root->cost[2] + 2 * CC_MOV_MEM : CC_INFINITY;
+    root->plan[1] = PLAN_BORROW;
+}
+
+static int asm_writes(BTNode* root, int addr) {
+    if (!root || !root->mutates)
+        return 0;
+    if (root->data == ASSIGN && get_addr(root->left->lexeme) == addr)
+        return 1;
+    return asm_writes(root->left, addr) || asm_writes(root->right, addr);
+}
+
+static void asm_ralloc(BTNode* node) {
+    switch (node->data) {
+    case ID: {
+        int addr = get_addr(node->lexeme);
+        if (var_vreg[addr / 4] == NO_REG_LABEL) {
+            var_vreg[addr / 4] = ir_vreg();
+            ir_emit(IR_MOV, IR_VREG(var_vreg[addr / 4]), IR_ADDR(addr));
+        }
+        node->reg = var_vreg[addr / 4];
         break;
-    case '*':
-        fprintf(stdout, "MUL r%d r%d\n", former_reg, latter_reg);
+    }
+    case INT:
+        node->reg = ir_vreg();
+        ir_emit(IR_MOV, IR_VREG(node->reg), IR_CONST(atoi(node->lexeme)));
         break;
-    case '/':
-        fprintf(stdout, "DIV r%d r%d\n", arith_root->left->reg, arith_root->right->reg);
-        if (arith_root->left->reg == latter_reg)
-            fprintf(stdout, "MOV r%d r%d\n", former_reg, latter_reg);
+    default:
+        return;
+    }
+}
+
+static void asm_assign(BTNode* assign_root, int k) {
+    int addr = get_addr(assign_root->left->lexeme);
+    asm_generate(assign_root->right, k);
+    ir_emit(IR_MOV, IR_ADDR(addr), IR_VREG(assign_root->right->reg));
+    var_vreg[addr / 4] = assign_root->right->reg;
+    assign_root->reg = assign_root->right->reg;
+}
+
+static void asm_reduce_emit(BTNode* root, int k) {
+    AsmReduction reduction;
+    asm_reduce(root, &reduction);
+    if (reduction.operand)
+        asm_generate(reduction.operand, k);
+    if (reduction.is_constant) {
+        root->reg = ir_vreg();
+        ir_emit(IR_MOV, IR_VREG(root->reg), IR_CONST(reduction.constant));
+        return;
+    }
+    int x = reduction.operand->reg;
+    if (reduction.count == 0) {
+        root->reg = x;
+        return;
+    }
+    int t = x;
+    for (int i = 0; i < reduction.count; i++) {
+        // the steps work on a copy, `x` is still read
+        if (t == x && reduction.step[i] != REDUCE_NEGATE) {
+            t = ir_vreg();
+            ir_emit(IR_MOV, IR_VREG(t), IR_VREG(x));
+        }
+        switch (reduction.step[i]) {
+        case REDUCE_DOUBLE:
+            ir_emit(IR_ADD, IR_VREG(t), IR_VREG(t));
+            break;
+        case REDUCE_ADD:
+            ir_emit(IR_ADD, IR_VREG(t), IR_VREG(x));
+            break;
+        case REDUCE_SUB:
+            ir_emit(IR_SUB, IR_VREG(t), IR_VREG(x));
+            break;
+        case REDUCE_NEGATE: {
+            int n = ir_vreg();
+            ir_emit(IR_MOV, IR_VREG(n), IR_CONST(0));
+            ir_emit(IR_SUB, IR_VREG(n), IR_VREG(t));
+            t = n;
+            break;
+        }
+        }
+    }
+    root->reg = t;
+}
+
+static void asm_arithmetic(BTNode* arith_root, int k) {
+    switch (arith_root->plan[k]) {
+    case PLAN_BORROW:
+        asm_arithmetic(arith_root, 2);
+        return;
+    case PLAN_REDUCE:
+        asm_reduce_emit(arith_root, k);
+        return;
+    case PLAN_LEFT_FIRST:
+        asm_generate(arith_root->left, k);
+        asm_generate(arith_root->right, k - 1);
         break;
-    case '|':
-        fprintf(stdout, "OR r%d r%d\n", former_reg, latter_reg);
+    case PLAN_SPILL_LEFT:
+        // the order of `PLAN_LEFT_FIRST`, `reg_alloc()` spills the left vreg if the right needs all `k`
+        asm_generate(arith_root->left, k);
+        asm_generate(arith_root->right, k);
         break;
-    case '^':
-        fprintf(stdout, "XOR r%d r%d\n", former_reg, latter_reg);
+    case PLAN_RIGHT_FIRST:
+        asm_generate(arith_root->right, k);
+        asm_generate(arith_root->left, k - 1);
         break;
-    case '&':
-        fprintf(stdout, "AND r%d r%d\n", former_reg, latter_reg);
+    case PLAN_SPILL_RIGHT:
+        // the order of `PLAN_RIGHT_FIRST`, likewise
+        asm_generate(arith_root->right, k);
+        asm_generate(arith_root->left, k);
         break;
     }
 
-    arith_root->reg = former_reg;
+    IROpcode opcode = asm_opcode(arith_root->lexeme[0]);
 
-    if (release_register)
-        fprintf(stdout, "MOV r6 [%d]\n", ++mem_label * 4);
-    else
-        reg_label--;
+    // 2-address: copy the left operand first, `reg_alloc()` coalesces the copy when it dies here
+    arith_root->reg = ir_vreg();
+    ir_emit(IR_MOV, IR_VREG(arith_root->reg), IR_VREG(arith_root->left->reg));
+    ir_emit(opcode, IR_VREG(arith_root->reg), IR_VREG(arith_root->right->reg));
 }
-#undef MIN
-#undef MAX
 
-static void asm_generate(BTNode* root) {
+static void asm_generate(BTNode* root, int k) {
     if (!root)
         return;
     switch (root->data) {
@@ -142,24 +491,128 @@ static void asm_generate(BTNode* root) {
         asm_ralloc(root);
         break;
     case ASSIGN:
-        asm_assign(root);
+        asm_assign(root, k);
         break;
     default:
-        asm_arithmetic(root);
+        asm_arithmetic(root, k);
         break;
     }
 }
 
-void generate_assembly(BTNode* root) {
+static void asm_statement(BTNode* root) {
     if (!root)
         return;
     if (root->data == ASSIGN) {
-        asm_generate(root);
-        reg_label--;
+        asm_label(root);
+        asm_generate(root, REG_COUNT);
     } else {
-        generate_assembly(root->left);
-        generate_assembly(root->right);
+        asm_statement(root->left);
+        asm_statement(root->right);
+    }
+}
+
+void generate_prologue(void) {
+    asm_finishing = 0;
+    stmt_label = 0;
+    var_vreg_size = 0;
+    ir_program.size = 0;
+    ir_program.vreg_count = 0;
+    ir_stmt = 0;
+}
+
+void generate_assembly(BTNode* root) {
+    if (var_vreg_size < sbcount) {
+        int size = var_vreg_size * 2 > sbcount ? var_vreg_size * 2 : sbcount;
+        var_vreg = (int*)realloc(var_vreg, size * sizeof(int));
+        for (int i = var_vreg_size; i < size; i++)
+            var_vreg[i] = NO_REG_LABEL;
+        var_vreg_size = size;
+    }
+    ir_stmt = ++stmt_label;
+    stmt_line = (int*)realloc(stmt_line, (stmt_label + 1) * sizeof(int));
+    stmt_line[stmt_label] = src_line;
+    asm_statement(root);
+}
+
+/**
+ * Write `prog` to the `-b` object
+ * @param prog 
+ */
+static void asm_write_object(const IRProgram* prog) {
+    FILE* object = fopen(opt_object, "wb");
+    if (!object || !ir_write_object(prog, mem_words, object))
+        fprintf(stderr, "cannot write '%s'\n", opt_object);
+    if (object)
+        fclose(object);
+}
+
+/**
+ * End the program with `EXIT status` as a statement of its own, then run the passes over it
+ *
+ * @param load load `x/y/z` into `r0..r2` before exiting
+ * @param status
+ */
+static void asm_finish(int load, int status) {
+    asm_finishing = 1;
+    ir_stmt = ++stmt_label;
+    stmt_line = (int*)realloc(stmt_line, (stmt_label + 1) * sizeof(int));
+    stmt_line[stmt_label] = 0;
+    if (load) {
+        ir_emit(IR_MOV, IR_REG(0), IR_ADDR(0));
+        ir_emit(IR_MOV, IR_REG(1), IR_ADDR(4));
+        ir_emit(IR_MOV, IR_REG(2), IR_ADDR(8));
+    }
+    ir_emit(IR_EXIT, IR_CONST(status), IR_NONE);
+    if (ir_extensions)
+        inst_select(&ir_program, opt_report);
+    reg_alloc(&ir_program, opt_level >= 2, opt_report);
+    if (opt_level >= 1)
+        peephole(&ir_program, opt_report);
+    if (opt_cache)
+        layout(&ir_program, opt_report);
+    if (opt_issue_width > 0)
+        schedule(&ir_program, opt_issue_width, opt_report);
+}
+
+void generate_epilogue(void) {
+    asm_finish(1, 0);
+}
+
+int generate_error_exit(void) {
+    if (asm_finishing)
+        return 0;
+    asm_finish(0, 1);
+    return 1;
+}
+
+void write_program(void) {
+    if (opt_object)
+        asm_write_object(&ir_program);
+    else
+        ir_print(&ir_program, stdout);
+    if (opt_line_map) {
+        FILE* map = fopen(opt_line_map, "w");
+        if (!map) {
+            fprintf(stderr, "cannot open '%s'\n", opt_line_map);
+            return;
+        }
+        ir_print_lines(&ir_program, stmt_line, map);
+        fclose(map);
+    }
+}
+
+void emit_error_exit(void) {
+    // the statements accepted so far, as the compiler printed them one by one before buffering
+    if (generate_error_exit()) {
+        write_program();
+        return;
     }
+    if (opt_object) {
+        IRInst exit_1 = { .opcode = IR_EXIT, .op1 = IR_CONST(1), .op2 = IR_NONE, .op3 = IR_NONE };
+        IRProgram prog = { &exit_1, 1, 1, 0 };
+        asm_write_object(&prog);
+    } else
+        fprintf(stdout, "EXIT 1\n");
 }
 
 int evaluateTree(BTNode* root) {
@@ -192,7 +645,8 @@ int evaluateTree(BTNode* root) {
                     // if we need exact value of the tree, we should garentee that this tree is pure-number tree
                     if (rv == 0 && root->right->data == INT)
                         error(DIVZERO, "");
-                    retval = rv == 0
+                    // INT_MIN / -1 keeps the dividend too, as the simulator's DIV does
+                    retval = rv == 0 || (rv == -1 && lv == INT_MIN)
                         ? lv
                         : lv / rv;
                 }
@@ -3,9 +3,44 @@
 
 #include "parser.h"
 
+/**
+ * Set by `-r`, print per statement spill costs on stderr
+ */
+extern int opt_report;
+
+/**
+ * Set by `-O<n>`, from `2` on registers are allocated by graph colouring instead of linear scan
+ */
+extern int opt_level;
+
+/**
+ * Set by `-p<w>`, list-schedule for a pipeline issuing `w` instructions per cycle, `0` keeps the order
+ */
+extern int opt_issue_width;
+
+/**
+ * Set by `-c`, lay the variables out for the simulator's data cache
+ */
+extern int opt_cache;
+
+/**
+ * Set by `-b<path>`, write the program there as a binary object instead of text on stdout
+ */
+extern const char* opt_object;
+
+/**
+ * Set by `-l<path>`, write the line map of the program there, see `ir_print_lines()`
+ */
+extern const char* opt_line_map;
+
 // Evaluate the syntax tree
 extern int evaluateTree(BTNode *root);
 
+/**
+ * Start a new program, forget the statements of the last one
+ */
+extern void generate_prologue(void);
+
 /**
  * Generate necessary asm
  * recurse to `TokenSet::ASSIGN` to generate asm, others need not to generate
@@ -14,6 +49,23 @@ extern int evaluateTree(BTNode *root);
  */
 extern void generate_assembly(BTNode* root);
 
+/**
+ * Load `x/y/z` into `r0..r2`, exit, then allocate registers for the
+ * whole buffered program, `ir_program` is final
+ */
+extern void generate_epilogue(void);
+
+/**
+ * Exit 1 after the statements accepted so far, then run the passes as `generate_epilogue()` does
+ * @returns `0` when the error comes from the passes, `ir_program` is not final then
+ */
+extern int generate_error_exit(void);
+
+/**
+ * Print the program, or write its `-b` object, and its `-l` line map
+ */
+extern void write_program(void);
+
 // Print the syntax tree in prefix
 extern void printPrefix(BTNode *root);
 
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "parser.h"
+#include "instSelect.h"
+
+/**
+ * Whether the extension operand `op` costs less than loading it into a register first
+ * a memory operand at the same price still saves the register
+ *
+ * @param op
+ */
+static int is_profitable(IROperand op) {
+    if (op.type == OPD_CONST)
+        return (ir_extensions & IR_EXT_IMM) && CC_EXT_IMM < CC_MOV_REG;
+    if (op.type == OPD_ADDR)
+        return (ir_extensions & IR_EXT_MEM) && CC_EXT_MEM <= CC_MOV_MEM;
+    return 0;
+}
+
+void inst_select(IRProgram* prog, int report) {
+    int* uses = (int*)calloc(prog->vreg_count, sizeof(int));
+    int* defs = (int*)calloc(prog->vreg_count, sizeof(int));
+    int* def_at = (int*)malloc(prog->vreg_count * sizeof(int));
+    int* last_store = (int*)malloc(mem_words * sizeof(int));
+    char* removed = (char*)calloc(prog->size + 1, 1);
+    int folded[2] = { 0 };
+    int saved[2] = { 0 };
+
+    for (int i = 0; i < prog->size; i++) {
+        const IRInst* inst = &prog->inst[i];
+        if (ir_reads_op1(inst) && inst->op1.type == OPD_VREG)
+            uses[inst->op1.value]++;
+        if (inst->op2.type == OPD_VREG)
+            uses[inst->op2.value]++;
+        if (ir_defines(inst) && inst->op1.type == OPD_VREG) {
+            defs[inst->op1.value]++;
+            def_at[inst->op1.value] = i;
+        }
+    }
+    for (int a = 0; a < mem_words; a++)
+        last_store[a] = -1;
+
+    for (int j = 0; j < prog->size; j++) {
+        IRInst* user = &prog->inst[j];
+        if (user->opcode == IR_MOV && user->op1.type == OPD_ADDR)
+            last_store[user->op1.value / 4] = j;
+        if (!ir_reads_op1(user) || user->op2.type != OPD_VREG)
+            continue;
+        int v = user->op2.value;
+        if (uses[v] != 1 || defs[v] != 1 || (user->op1.type == OPD_VREG && user->op1.value == v))
+            continue;
+        IRInst* def = &prog->inst[def_at[v]];
+        if (def->opcode != IR_MOV || !is_profitable(def->op2))
+            continue;
+        // the variable must not be stored between the load and its use
+        if (def->op2.type == OPD_ADDR && last_store[def->op2.value / 4] > def_at[v])
+            continue;
+
+        int ext = def->op2.type == OPD_CONST ? 0 : 1;
+        int before = ir_cycles(def) + ir_cycles(user);
+        user->op2 = def->op2;
+        removed[def_at[v]] = 1;
+        folded[ext]++;
+        saved[ext] += before - ir_cycles(user);
+    }
+
+    int size = 0;
+    for (int i = 0; i < prog->size; i++)
+        if (!removed[i])
+            prog->inst[size++] = prog->inst[i];
+    prog->size = size;
+
+    if (report) {
+        if (ir_extensions & IR_EXT_IMM)
+            fprintf(stderr, "immediate operands: %d folded, %dcc saved\n", folded[0], saved[0]);
+        if (ir_extensions & IR_EXT_MEM)
+            fprintf(stderr, "memory operands: %d folded, %dcc saved\n", folded[1], saved[1]);
+    }
+    free(uses);
+    free(defs);
+    free(def_at);
+    free(last_store);
+    free(removed);
+}
@@ -0,0 +1,16 @@
+#ifndef __INSTSELECT__
+#define __INSTSELECT__
+
+#include "ir.h"
+
+/**
+ * Fold single-use constants and variable loads into the arithmetic reading them,
+ * using the forms `ir_extensions` enables; runs before `reg_alloc()` so the
+ * folded operands need no register
+ *
+ * @param prog
+ * @param report print how many cycles every extension saved on stderr
+ */
+extern void inst_select(IRProgram* prog, int report);
+
+#endif // __INSTSELECT__
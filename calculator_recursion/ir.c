@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ir.h"
+#include "../assembly_parser/machine.h"
+#include "../assembly_parser/analyze.h"
+#include "../assembly_parser/object.h"
+
+IRProgram ir_program = { NULL, 0, 0, 0 };
+int ir_stmt = 0;
+IRTarget ir_target = TARGET_2ADDR;
+int ir_extensions = 0;
+
+int ir_cycles(const IRInst* inst) {
+    if (inst->opcode == IR_MOV && (inst->op1.type == OPD_ADDR || inst->op2.type == OPD_ADDR
+        || inst->op1.type == OPD_SLOT || inst->op2.type == OPD_SLOT))
+        return CC_MOV_MEM;
+    if (inst->opcode == IR_MOV || inst->opcode == IR_EXIT)
+        return opcodes[inst->opcode].cycles;
+    IROperandType rhs = inst->op3.type != OPD_NONE ? inst->op3.type : inst->op2.type;
+    return opcodes[inst->opcode].cycles + (rhs == OPD_CONST ? CC_EXT_IMM : rhs == OPD_ADDR ? CC_EXT_MEM : 0);
+}
+
+int ir_vreg(void) {
+    return ir_program.vreg_count++;
+}
+
+void ir_push(IRProgram* prog, IRInst inst) {
+    if (prog->size == prog->capacity) {
+        prog->capacity = prog->capacity ? prog->capacity * 2 : 256;
+        prog->inst = (IRInst*)realloc(prog->inst, prog->capacity * sizeof(IRInst));
+        if (!prog->inst) {
+            fprintf(stderr, "out of memory while buffering instructions\n");
+            exit(0);
+        }
+    }
+    prog->inst[prog->size++] = inst;
+}
+
+void ir_emit(IROpcode opcode, IROperand op1, IROperand op2) {
+    ir_push(&ir_program, (IRInst){ .opcode = opcode, .op1 = op1, .op2 = op2, .stmt = ir_stmt, .origin = ORIGIN_CODE, .op3 = IR_NONE });
+}
+
+int ir_defines(const IRInst* inst) {
+    return inst->opcode != IR_EXIT && (inst->op1.type == OPD_VREG || inst->op1.type == OPD_REG);
+}
+
+int ir_reads_op1(const IRInst* inst) {
+    return inst->opcode != IR_MOV && inst->opcode != IR_EXIT && inst->op3.type == OPD_NONE;
+}
+
+// `ir_print()` formats this many bytes before writing them out in one go
+#define IR_PRINT_BLOCK (1 << 16)
+// longest line: opcode, 4 operands of ` [s-2147483648]` and the newline
+#define IR_LINE_MAX 72
+
+static char* ir_put_str(char* p, const char* s) {
+    while (*s)
+        *p++ = *s++;
+    return p;
+}
+
+static char* ir_put_operand(char* p, IROperand op) {
+    switch (op.type) {
+    case OPD_VREG:
+        *p++ = ' ';
+        *p++ = 'v';
+        return put_int(p, op.value, 0);
+    case OPD_REG:
+        *p++ = ' ';
+        *p++ = 'r';
+        return put_int(p, op.value, 0);
+    case OPD_CONST:
+        *p++ = ' ';
+        return put_int(p, op.value, 0);
+    case OPD_ADDR:
+        *p++ = ' ';
+        *p++ = '[';
+        p = put_int(p, op.value, 0);
+        *p++ = ']';
+        return p;
+    case OPD_SLOT:
+        p = ir_put_str(p, " [s");
+        p = put_int(p, op.value, 0);
+        *p++ = ']';
+        return p;
+    case OPD_NONE:
+        break;
+    }
+    return p;
+}
+
+/**
+ * Kind of `inst` in the line map
+ * @param inst 
+ */
+static const char* ir_kind(const IRInst* inst) {
+    if (inst->origin == ORIGIN_STORE || inst->origin == ORIGIN_RELOAD)
+        return "spill";
+    if (inst->opcode == IR_EXIT)
+        return "exit";
+    if (inst->opcode != IR_MOV)
+        return "arithmetic";
+    if (inst->op1.type == OPD_ADDR)
+        return "store";
+    if (inst->op2.type == OPD_ADDR)
+        return "load";
+    // copies and rematerialized constants
+    return "arithmetic";
+}
+
+void ir_print_lines(const IRProgram* prog, const int* stmt_line, FILE* out) {
+    char block[IR_PRINT_BLOCK];
+    char* p = ir_put_str(block, "# line kind\n");
+    for (int i = 0; i < prog->size; i++) {
+        if (p - block > IR_PRINT_BLOCK - IR_LINE_MAX) {
+            fwrite(block, 1, p - block, out);
+            p = block;
+        }
+        p = put_int(p, stmt_line[prog->inst[i].stmt], 0);
+        *p++ = ' ';
+        p = ir_put_str(p, ir_kind(&prog->inst[i]));
+        *p++ = '\n';
+    }
+    fwrite(block, 1, p - block, out);
+}
+
+void ir_print(const IRProgram* prog, FILE* out) {
+    char block[IR_PRINT_BLOCK];
+    char* p = block;
+    for (int i = 0; i < prog->size; i++) {
+        const IRInst* inst = &prog->inst[i];
+        if (p - block > IR_PRINT_BLOCK - IR_LINE_MAX) {
+            fwrite(block, 1, p - block, out);
+            p = block;
+        }
+        p = ir_put_str(p, opcodes[inst->opcode].name);
+        p = ir_put_operand(p, inst->op1);
+        // `OP rd rs` is `OP rd rd rs` on a 3-address target
+        if (ir_target == TARGET_3ADDR && ir_reads_op1(inst))
+            p = ir_put_operand(p, inst->op1);
+        p = ir_put_operand(p, inst->op2);
+        p = ir_put_operand(p, inst->op3);
+        *p++ = '\n';
+    }
+    fwrite(block, 1, p - block, out);
+}
+
+/**
+ * The simulator's decoding of `op`, only registers, constants and addresses are left after `reg_alloc()`
+ * @param op 
+ * @param type 
+ * @param value 
+ */
+static void ir_inst_operand(IROperand op, enum op_type* type, int* value) {
+    static const enum op_type types[] = {
+        [OPD_NONE] = NONE,
+        [OPD_REG] = REG,
+        [OPD_CONST] = CONST,
+        [OPD_ADDR] = ADDR
+    };
+    *type = types[op.type];
+    *value = op.value;
+}
+
+// `IROpcode` indexes `opcodes[]` and converts to `enum code` as is
+#define IR_SAME_OPCODE(ir, code) ((int)(ir) == (int)(code))
+_Static_assert(IR_SAME_OPCODE(IR_MOV, MOV) && IR_SAME_OPCODE(IR_ADD, ADD) && IR_SAME_OPCODE(IR_SUB, SUB)
+    && IR_SAME_OPCODE(IR_MUL, MUL) && IR_SAME_OPCODE(IR_DIV, DIV) && IR_SAME_OPCODE(IR_AND, AND)
+    && IR_SAME_OPCODE(IR_OR, OR) && IR_SAME_OPCODE(IR_XOR, XOR) && IR_SAME_OPCODE(IR_EXIT, EXIT),
+    "IROpcode must match enum code");
+
+/**
+ * `inst` as the simulator decodes its printed line
+ * @param inst 
+ */
+static INST ir_to_inst(const IRInst* inst) {
+    IROperand op2 = inst->op2, op3 = inst->op3;
+    // as `ir_print()` writes it: EXIT has no second operand, `OP rd rs` is `OP rd rd rs` on a 3-address target
+    if (inst->opcode == IR_EXIT)
+        op2 = IR_CONST(0);
+    else if (ir_target == TARGET_3ADDR && ir_reads_op1(inst)) {
+        op2 = inst->op1;
+        op3 = inst->op2;
+    }
+    INST out;
+    out.opcode = (enum code)inst->opcode;
+    ir_inst_operand(inst->op1, &out.op1_type, &out.op1_value);
+    ir_inst_operand(op2, &out.op2_type, &out.op2_value);
+    ir_inst_operand(op3, &out.op3_type, &out.op3_value);
+    return out;
+}
+
+void ir_analyze(const IRProgram* prog, int width, int cache, int words, struct ANALYSIS* a) {
+    analyze_init(a, width, cache, words);
+    for (int i = 0; i < prog->size; i++) {
+        INST inst = ir_to_inst(&prog->inst[i]);
+        analyze_inst(a, &inst);
+    }
+}
+
+INST* ir_instructions(const IRProgram* prog) {
+    INST* inst = (INST*)malloc((prog->size + 1) * sizeof(INST));
+    for (int i = 0; i < prog->size; i++)
+        inst[i] = ir_to_inst(&prog->inst[i]);
+    return inst;
+}
+
+int ir_write_object(const IRProgram* prog, int words, FILE* out) {
+    INST* inst = ir_instructions(prog);
+    int ok = object_write(out, inst, prog->size, words);
+    free(inst);
+    return ok;
+}
@@ -0,0 +1,205 @@
+#ifndef __IR__
+#define __IR__
+
+#include <stdio.h>
+#include "../assembly_parser/inst.h"
+
+/**
+ * Opcodes of the target, the simulator's `enum code`
+ * their spelling and cycles are in its opcode table, `opcodes[]` in assembly_parser/inst.h
+ * @enum
+ */
+typedef enum ir_opcode_t {
+    IR_MOV = MOV,
+    IR_ADD = ADD,
+    IR_SUB = SUB,
+    IR_MUL = MUL,
+    IR_DIV = DIV,
+    IR_AND = AND,
+    IR_OR = OR,
+    IR_XOR = XOR,
+    IR_EXIT = EXIT
+} IROpcode;
+
+/**
+ * Operand kinds, `OPD_VREG` and `OPD_SLOT` only live until `reg_alloc()`
+ * @enum
+ */
+typedef enum ir_operand_type_t {
+    OPD_NONE,
+    OPD_VREG,  // virtual register, unbounded
+    OPD_REG,   // physical register `r0..r{REG_COUNT-1}`
+    OPD_CONST, // immediate
+    OPD_ADDR,  // byte address
+    OPD_SLOT   // spill slot of the vreg `value`, becomes an `OPD_ADDR`
+} IROperandType;
+
+/**
+ * Why an instruction exists, used by the reports
+ * @enum
+ */
+typedef enum ir_origin_t {
+    ORIGIN_CODE,   // emitted by codegen
+    ORIGIN_STORE,  // spill store to a slot
+    ORIGIN_RELOAD, // spill reload from a slot
+    ORIGIN_REMAT,  // rematerialized constant
+    ORIGIN_HOME    // reload of a variable from its own address
+} IROrigin;
+
+typedef struct {
+    IROperandType type;
+    int value;
+} IROperand;
+
+/**
+ * Instruction format of the target, chosen at startup
+ * @enum
+ */
+typedef enum ir_target_t {
+    TARGET_2ADDR, // OP rd rs: rd = rd <op> rs
+    TARGET_3ADDR  // OP rd rs rt: rd = rs <op> rt
+} IRTarget;
+
+/**
+ * One instruction, `op1 = op1 <opcode> op2` (`MOV` only writes `op1`)
+ * with `op3` set it is the 3-address `op1 = op2 <opcode> op3`, which only
+ * `peephole()` forms for `TARGET_3ADDR`
+ * @struct
+ */
+typedef struct {
+    IROpcode opcode;
+    IROperand op1;
+    IROperand op2;
+    int stmt;        // 1-based statement that produced it
+    IROrigin origin;
+    IROperand op3;   // `OPD_NONE` in the 2-address form
+} IRInst;
+
+/**
+ * Growable instruction vector of the whole program
+ * @struct
+ */
+typedef struct {
+    IRInst* inst;
+    int size;
+    int capacity;
+    int vreg_count;
+} IRProgram;
+
+/**
+ * The program being compiled
+ */
+extern IRProgram ir_program;
+
+/**
+ * Format `ir_print()` writes, arithmetic is always printed with 3 operands for `TARGET_3ADDR`
+ */
+extern IRTarget ir_target;
+
+/**
+ * ISA extensions the target accepts, `IR_EXT_*` bits
+ * the right operand of an arithmetic instruction may then be an immediate or a memory word
+ */
+extern int ir_extensions;
+
+#define IR_EXT_IMM 1 // ADD r1 5
+#define IR_EXT_MEM 2 // ADD r1 [8]
+
+/**
+ * Statement stamped on every `ir_emit()`
+ */
+extern int ir_stmt;
+
+/**
+ * Allocate a fresh virtual register
+ * @returns vreg number
+ */
+extern int ir_vreg(void);
+
+/**
+ * Append an instruction to `ir_program`
+ * @param opcode 
+ * @param op1 
+ * @param op2 
+ */
+extern void ir_emit(IROpcode opcode, IROperand op1, IROperand op2);
+
+/**
+ * Append `inst` to `prog`, growing it when needed
+ * @param prog 
+ * @param inst 
+ */
+extern void ir_push(IRProgram* prog, IRInst inst);
+
+/**
+ * Print the program in the simulator's text format
+ * @param prog 
+ * @param out 
+ */
+extern void ir_print(const IRProgram* prog, FILE* out);
+
+/**
+ * Write the line map of `prog`, one `<line> <kind>` row per printed instruction:
+ * the input line of its statement, `0` for the epilogue, and what it does,
+ * `load`, `store` or `spill` for memory traffic, `arithmetic` or `exit`
+ * the simulator's `-l<path>` attributes the cycles it charges with it
+ * @param prog 
+ * @param stmt_line input line of every statement
+ * @param out 
+ */
+extern void ir_print_lines(const IRProgram* prog, const int* stmt_line, FILE* out);
+
+/**
+ * Cycles the simulator charges for `inst`, its `cycles()` with spill slots in memory
+ * @param inst 
+ */
+extern int ir_cycles(const IRInst* inst);
+
+/**
+ * Whether `inst` writes its `op1` register
+ */
+extern int ir_defines(const IRInst* inst);
+
+/**
+ * Whether `inst` reads its `op1` register, only the 2-address arithmetic does
+ */
+extern int ir_reads_op1(const IRInst* inst);
+
+struct ANALYSIS;
+
+/**
+ * Static analysis of `prog` after `reg_alloc()`: the cycles, pipelined cycles, cache misses,
+ * register use and memory traffic the simulator reports, without running it
+ * see assembly_parser/analyze.h
+ * @param prog 
+ * @param width issue width of the pipelined timing, 0 to skip it
+ * @param cache whether to model the data cache
+ * @param words words of memory
+ * @param a initialized here, release it with `analyze_free()`
+ */
+extern void ir_analyze(const IRProgram* prog, int width, int cache, int words, struct ANALYSIS* a);
+
+/**
+ * `prog` after `reg_alloc()` as the simulator's instructions, exactly what `ir_print()` writes
+ * @param prog 
+ * @returns `prog->size` instructions, malloc'd
+ */
+extern INST* ir_instructions(const IRProgram* prog);
+
+/**
+ * Write `prog` after `reg_alloc()` as a binary object the simulator runs with `-x<path>`
+ * see assembly_parser/object.h
+ * @param prog 
+ * @param words words of memory the program needs
+ * @param out opened in binary mode
+ * @returns 0 when writing fails
+ */
+extern int ir_write_object(const IRProgram* prog, int words, FILE* out);
+
+#define IR_NONE ((IROperand){ OPD_NONE, 0 })
+#define IR_VREG(v) ((IROperand){ OPD_VREG, (v) })
+#define IR_REG(r) ((IROperand){ OPD_REG, (r) })
+#define IR_CONST(c) ((IROperand){ OPD_CONST, (c) })
+#define IR_ADDR(a) ((IROperand){ OPD_ADDR, (a) })
+
+#endif // __IR__
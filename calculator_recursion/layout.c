@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "layout.h"
+#include "../assembly_parser/analyze.h"
+
+#define LINE_WORDS (CACHE_LINE / 4)
+// an access counts as co-accessed with this many accesses before it in its statement
+#define LAYOUT_WINDOW 4
+// the simulator initializes `x`, `y` and `z` in these words
+#define LAYOUT_PINNED 3
+
+typedef struct {
+    int a;
+    int b;
+} LayoutPair;
+
+typedef struct {
+    int word;
+    int freq;
+} LayoutWord;
+
+/**
+ * Co-access graph of the memory words, in compressed rows
+ * the edges of word `w` are `[start[w], start[w + 1])`
+ * @struct
+ */
+typedef struct {
+    int* start;
+    int* to;
+    int* weight;
+} LayoutGraph;
+
+static const IROperand* lay_operand(const IRInst* inst) {
+    return inst->op1.type == OPD_ADDR ? &inst->op1
+        : inst->op2.type == OPD_ADDR ? &inst->op2
+        : inst->op3.type == OPD_ADDR ? &inst->op3
+        : NULL;
+}
+
+static int lay_pair_cmp(const void* x, const void* y) {
+    const LayoutPair* p = (const LayoutPair*)x;
+    const LayoutPair* q = (const LayoutPair*)y;
+    return p->a != q->a ? p->a - q->a : p->b - q->b;
+}
+
+static int lay_word_cmp(const void* x, const void* y) {
+    const LayoutWord* p = (const LayoutWord*)x;
+    const LayoutWord* q = (const LayoutWord*)y;
+    return p->freq != q->freq ? q->freq - p->freq : p->word - q->word;
+}
+
+/**
+ * Misses of the simulator's cache over the accesses of `prog`, the program is straight-line
+ * so this is exact
+ *
+ * @param prog
+ * @param map new word of every word, `NULL` for the current layout
+ */
+static int lay_misses(const IRProgram* prog, const int* map) {
+    CACHE cache = { .on = 1 };
+    memset(cache.line, -1, sizeof(cache.line));
+    for (int i = 0; i < prog->size; i++) {
+        const IROperand* op = lay_operand(&prog->inst[i]);
+        if (op)
+            cache_access(&cache, (map ? map[op->value / 4] : op->value / 4) * 4);
+    }
+    return cache.misses;
+}
+
+/**
+ * Build the co-access graph, pairs of distinct words accessed close together in one statement
+ *
+ * @param prog
+ * @param freq accesses of every word, filled
+ * @param graph
+ */
+static void lay_graph(const IRProgram* prog, int* freq, LayoutGraph* graph) {
+    LayoutPair* pair = NULL;
+    int pair_count = 0, pair_capacity = 0;
+    int recent[LAYOUT_WINDOW];
+    int recent_count = 0, stmt = -1;
+    for (int i = 0; i < prog->size; i++) {
+        const IROperand* op = lay_operand(&prog->inst[i]);
+        if (!op)
+            continue;
+        int w = op->value / 4;
+        freq[w]++;
+        if (prog->inst[i].stmt != stmt) {
+            stmt = prog->inst[i].stmt;
+            recent_count = 0;
+        }
+        for (int k = 0; k < recent_count && k < LAYOUT_WINDOW; k++) {
+            if (recent[k] == w)
+                continue;
+            if (pair_count == pair_capacity) {
+                pair_capacity = pair_capacity ? pair_capacity * 2 : 64;
+                pair = (LayoutPair*)realloc(pair, pair_capacity * sizeof(LayoutPair));
+            }
+            pair[pair_count++] = recent[k] < w ? (LayoutPair){ recent[k], w } : (LayoutPair){ w, recent[k] };
+        }
+        recent[recent_count++ % LAYOUT_WINDOW] = w;
+    }
+    qsort(pair, pair_count, sizeof(LayoutPair), lay_pair_cmp);
+
+    // repeated pairs become the weight of one edge, stored in the rows of both words
+    int edges = 0;
+    graph->start = (int*)calloc(mem_words + 1, sizeof(int));
+    for (int i = 0; i < pair_count; i++)
+        if (i == 0 || lay_pair_cmp(&pair[i], &pair[i - 1])) {
+            graph->start[pair[i].a + 1]++;
+            graph->start[pair[i].b + 1]++;
+            edges++;
+        }
+    for (int w = 0; w < mem_words; w++)
+        graph->start[w + 1] += graph->start[w];
+    graph->to = (int*)malloc((2 * edges + 1) * sizeof(int));
+    graph->weight = (int*)malloc((2 * edges + 1) * sizeof(int));
+    int* fill = (int*)malloc(mem_words * sizeof(int));
+    memcpy(fill, graph->start, mem_words * sizeof(int));
+    for (int i = 0, j; i < pair_count; i = j) {
+        for (j = i; j < pair_count && !lay_pair_cmp(&pair[i], &pair[j]); j++)
+            ;
+        int a = pair[i].a, b = pair[i].b;
+        graph->to[fill[a]] = b;
+        graph->weight[fill[a]++] = j - i;
+        graph->to[fill[b]] = a;
+        graph->weight[fill[b]++] = j - i;
+    }
+    free(fill);
+    free(pair);
+}
+
+/**
+ * Add the edges of `w`, just placed in the line being filled, to the score of its neighbours
+ *
+ * @param graph
+ * @param w
+ * @param score affinity of every word to the line
+ * @param touched words with a score, appended to
+ * @param touched_count
+ */
+static void lay_attract(const LayoutGraph* graph, int w, int* score, int* touched, int* touched_count) {
+    for (int e = graph->start[w]; e < graph->start[w + 1]; e++) {
+        if (score[graph->to[e]] == 0)
+            touched[(*touched_count)++] = graph->to[e];
+        score[graph->to[e]] += graph->weight[e];
+    }
+}
+
+void layout(IRProgram* prog, int report) {
+    int* freq = (int*)calloc(mem_words, sizeof(int));
+    LayoutGraph graph;
+    lay_graph(prog, freq, &graph);
+
+    LayoutWord* hot = (LayoutWord*)malloc(mem_words * sizeof(LayoutWord));
+    int hot_count = 0;
+    for (int w = LAYOUT_PINNED; w < mem_words; w++)
+        if (freq[w])
+            hot[hot_count++] = (LayoutWord){ w, freq[w] };
+    qsort(hot, hot_count, sizeof(LayoutWord), lay_word_cmp);
+
+    int* map = (int*)malloc(mem_words * sizeof(int));
+    int* at = (int*)malloc(mem_words * sizeof(int));
+    int* score = (int*)calloc(mem_words, sizeof(int));
+    int* touched = (int*)malloc(mem_words * sizeof(int));
+    int touched_count = 0;
+    for (int w = 0; w < mem_words; w++)
+        map[w] = at[w] = w < LAYOUT_PINNED ? w : -1;
+
+    // fill line by line with the word most co-accessed with the line so far,
+    // a line nothing is attracted to starts with the hottest word left
+    for (int n = LAYOUT_PINNED, next_hot = 0; n < LAYOUT_PINNED + hot_count; n++) {
+        if (n == LAYOUT_PINNED || n % LINE_WORDS == 0) {
+            for (int k = 0; k < touched_count; k++)
+                score[touched[k]] = 0;
+            touched_count = 0;
+            for (int m = n - n % LINE_WORDS; m < n; m++)
+                lay_attract(&graph, at[m], score, touched, &touched_count);
+        }
+        int best = -1;
+        for (int k = 0; k < touched_count; k++) {
+            int c = touched[k];
+            if (map[c] < 0 && (best < 0 || score[c] > score[best]
+                || (score[c] == score[best] && freq[c] > freq[best])))
+                best = c;
+        }
+        if (best < 0) {
+            while (map[hot[next_hot].word] >= 0)
+                next_hot++;
+            best = hot[next_hot].word;
+        }
+        map[best] = n;
+        at[n] = best;
+        lay_attract(&graph, best, score, touched, &touched_count);
+    }
+
+    int before = lay_misses(prog, NULL);
+    int after = lay_misses(prog, map);
+    if (after < before)
+        for (int i = 0; i < prog->size; i++) {
+            IROperand* op = (IROperand*)lay_operand(&prog->inst[i]);
+            if (op)
+                op->value = map[op->value / 4] * 4;
+        }
+    if (report)
+        fprintf(stderr, "layout: %d words, %d cache misses before, %d after%s\n",
+            hot_count + LAYOUT_PINNED, before, after, after < before ? "" : " (kept)");
+
+    free(freq);
+    free(graph.start);
+    free(graph.to);
+    free(graph.weight);
+    free(hot);
+    free(map);
+    free(at);
+    free(score);
+    free(touched);
+}
@@ -0,0 +1,17 @@
+#ifndef __LAYOUT__
+#define __LAYOUT__
+
+#include "ir.h"
+
+/**
+ * Reassign the memory words of `prog` so variables accessed together share a cache line
+ * hot words are packed first, `x`, `y` and `z` keep the words `0..2`
+ * the new layout is kept only when it misses less in the simulator's cache, see machine.h
+ * runs after `reg_alloc()`, every memory operand must be an address
+ *
+ * @param prog
+ * @param report print the cache misses before and after on stderr
+ */
+extern void layout(IRProgram* prog, int report);
+
+#endif // __LAYOUT__
@@ -3,14 +3,34 @@
 #include <string.h>
 #include <ctype.h>
 #include "lex.h"
+#include "parser.h"
 
 /**
- * Get token from stdin stream, put the token string into `lexeme[]`
+ * Get token from the input, put the token string into `lexeme[]`
  * @returns token type
  */
 static TokenSet getToken(void);
 static TokenSet curToken = UNKNOWN;
 static char lexeme[MAXLEN];
+/**
+ * Source set by `lex_source()`, stdin while `NULL`
+ */
+static const char* src = NULL;
+static int src_len = 0;
+static int src_pos = 0;
+
+static int lex_getc(void) {
+    if (!src)
+        return fgetc(stdin);
+    return src_pos < src_len ? (unsigned char)src[src_pos++] : EOF;
+}
+
+static void lex_ungetc(int c) {
+    if (!src)
+        ungetc(c, stdin);
+    else if (c != EOF && src_pos > 0)
+        src_pos--;
+}
 
 static int isvariablebody(char c) {
     return isalnum(c) || c == '_';
@@ -24,25 +44,25 @@ TokenSet getToken(void) {
     char c = '\0';
 
     // remove preceeding null charactor
-    while ((c = fgetc(stdin)) == ' ' || c == '\t');
+    while ((c = lex_getc()) == ' ' || c == '\t');
     // now `c` is a non-null char
 
     if (isdigit(c)) {
         // INT part
         lexeme[0] = c;
-        c = fgetc(stdin);
+        c = lex_getc();
         i = 1;
         while (isdigit(c) && i < MAXLEN) {
             lexeme[i] = c;
             ++i;
-            c = fgetc(stdin);
+            c = lex_getc();
         }
         // now `c` is not a digit (or i == MAXLEN)
-        ungetc(c, stdin);
+        lex_ungetc(c);
         // put boundary check first :)
         if (i == MAXLEN) {
             fprintf(stderr, "buffer error: single token exceeds lexical buffer\n");
-            exit(0);
+            compile_exit();
         }
         lexeme[i] = '\0';
         return INT;
@@ -51,7 +71,7 @@ TokenSet getToken(void) {
         lexeme[0] = c;
         // check if is single `+` `-` or not
         // first take out the following char from stream
-        char preceeding = fgetc(stdin);
+        char preceeding = lex_getc();
         // here c may be  `+` or `-`
         // check `preceeding == c` means `++` `--`
         // check `preceeding == =` means `+=` `-=`
@@ -69,7 +89,7 @@ TokenSet getToken(void) {
         } else {
             // ADDSUB
             // don't forget to push back stream
-            ungetc(preceeding, stdin);
+            lex_ungetc(preceeding);
             lexeme[1] = '\0';
             return ADDSUB;
         }
@@ -105,18 +125,18 @@ TokenSet getToken(void) {
     } else if (isvariablebody(c)) {
         // vairable part
         lexeme[0] = c;
-        c = fgetc(stdin);
+        c = lex_getc();
         i = 1;
         while (isvariablebody(c) && i < MAXLEN) {
             lexeme[i] = c;
             ++i;
-            c = fgetc(stdin);
+            c = lex_getc();
         }
-        ungetc(c, stdin);
+        lex_ungetc(c);
         // put boundary check first :)
         if (i == MAXLEN) {
             fprintf(stderr, "buffer error: single token exceeds lexical buffer\n");
-            exit(0);
+            compile_exit();
         }
         lexeme[i] = '\0';
         return ID;
@@ -128,6 +148,13 @@ TokenSet getToken(void) {
     }
 }
 
+void lex_source(const char* text, int len) {
+    src = text;
+    src_len = len;
+    src_pos = 0;
+    curToken = UNKNOWN;
+}
+
 void advance(void) {
     curToken = getToken();
 }
@@ -25,6 +25,13 @@ typedef enum token_set_t {
     RPAREN         // )
 } TokenSet;
 
+/**
+ * Read the tokens from `len` bytes at `text` instead of stdin, from the start
+ * @param text `NULL` goes back to stdin
+ * @param len 
+ */
+extern void lex_source(const char* text, int len);
+
 /**
  * Test if a token matches the current token
  * @param token 
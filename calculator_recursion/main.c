@@ -4,6 +4,8 @@
 #include <ctype.h>
 #include "lex.h"
 #include "parser.h"
+#include "codeGen.h"
+#include "ir.h"
 
 // This package is a calculator
 // It works like a Python interpretor
@@ -28,12 +30,35 @@
 //		   	      LPAREN expr RPAREN |
 //		   	      ADDSUB LPAREN expr RPAREN
 
-int main() {
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "-r") == 0)
+            opt_report = 1;
+        else if (strncmp(argv[i], "-O", 2) == 0)
+            opt_level = atoi(argv[i] + 2);
+        else if (strcmp(argv[i], "-t3") == 0)
+            ir_target = TARGET_3ADDR;
+        else if (strcmp(argv[i], "-t2") == 0)
+            ir_target = TARGET_2ADDR;
+        else if (strcmp(argv[i], "-xi") == 0)
+            ir_extensions |= IR_EXT_IMM;
+        else if (strcmp(argv[i], "-xm") == 0)
+            ir_extensions |= IR_EXT_MEM;
+        else if (strncmp(argv[i], "-p", 2) == 0)
+            opt_issue_width = atoi(argv[i] + 2);
+        else if (strcmp(argv[i], "-c") == 0)
+            opt_cache = 1;
+        else if (strncmp(argv[i], "-m", 2) == 0)
+            mem_words = atoi(argv[i] + 2);
+        else if (strncmp(argv[i], "-b", 2) == 0)
+            opt_object = argv[i] + 2;
+        else if (strncmp(argv[i], "-l", 2) == 0)
+            opt_line_map = argv[i] + 2;
     initTable();
     if (PRINTERR)
         printf(">> ");
-    while (1) {
-        statement();
-    }
+    while (statement())
+        ;
+    write_program();
     return 0;
 }
@@ -1,8 +1,14 @@
 #ifndef __PARSER__
 #define __PARSER__
 
+#include <setjmp.h>
 #include "lex.h"
-#define TBLSIZE 64
+#include "../assembly_parser/machine.h"
+
+/**
+ * One word of simulator memory per variable, `REG_COUNT` and `MEMSIZE` come from machine.h
+ * variables grow up from address `0`, spill slots follow the last variable
+ */
 #define NO_REG_LABEL -1
 
 /**
@@ -14,14 +20,16 @@
 /**
  * Macro to print error message and exit the program
  * This will also print where you called it in your program
+ * a compile of the in-process API returns to `compile_abort` instead, see api.h
  */
 #define error(errorNum, detail) {\
-    fprintf(stdout, "EXIT 1\n");\
+    if (!compile_abort)\
+        emit_error_exit();\
     if (PRINTERR) {\
         fprintf(stderr, "error() called at %s:%d\n", __FILE__, __LINE__);\
         err(errorNum, detail);\
     }\
-    exit(0);\
+    compile_exit();\
 }
 
 /**
@@ -56,18 +64,49 @@ typedef struct _Node {
     TokenSet data;
     int val;
     int reg;
+    int mutates;               // subtree contains `=`, evaluation order must be kept
+    int cost[REG_COUNT + 1];   // min cycles to evaluate into a register with `k` free registers
+    int plan[REG_COUNT + 1];   // the `AsmPlan` reaching `cost[k]`
     char lexeme[MAXLEN];
     struct _Node *left; 
     struct _Node *right;
+    struct _Node *live_prev;   // nodes made and not freed yet, see `freeLiveNodes()`
+    struct _Node *live_next;
 } BTNode;
 
 /**
- * The symbol table
+ * The symbol table, grows with `sbcount`
+ */
+extern Symbol* table;
+
+/**
+ * Words of simulator memory the program may use, set by `-m<n>`, `MEMSIZE` by default
+ * variables and spill slots must fit
+ */
+extern int mem_words;
+
+/**
+ * 1-based input line of the statement being parsed
+ */
+extern int src_line;
+
+/**
+ * Count of registered variables, they occupy words `[0, sbcount)`
+ */
+extern int sbcount;
+
+/**
+ * Set while the in-process API compiles, a failed compile longjmp()s there instead of exiting
  */
-extern Symbol table[TBLSIZE];
+extern jmp_buf* compile_abort;
 
 /**
- * There would be `x/y/z` symbol initially, value is `0`
+ * Stop compiling: longjmp() to `compile_abort` when set, exit the program otherwise
+ */
+extern _Noreturn void compile_exit(void);
+
+/**
+ * Start over with only the `x/y/z` symbols, value is `0`
  */
 extern void initTable(void);
 
@@ -111,7 +150,16 @@ extern BTNode* makeNode(TokenSet tok, const char* lexe);
  */
 extern void freeTree(BTNode *root);
 
-extern void statement(void);
+/**
+ * Free every node not freed yet, the partial trees of the statement an error() abandoned
+ */
+extern void freeLiveNodes(void);
+
+/**
+ * Parse and generate one statement
+ * @returns `0` at the end of the input, after `generate_epilogue()`
+ */
+extern int statement(void);
 extern BTNode* assign_expr(void);
 extern BTNode* or_expr(void);
 extern BTNode* or_expr_tail(BTNode* left);
@@ -129,4 +177,11 @@ extern BTNode* factor(void);
 // Print error message and exit the program
 extern void err(ErrorType errorNum, char* detail);
 
+/**
+ * Output of a failed compile, as text or as the `-b` object: the statements accepted
+ * before the error, then `EXIT 1`; only `EXIT 1` when the error comes from the passes
+ * defined in codeGen.c
+ */
+extern void emit_error_exit(void);
+
 #endif // __PARSER__
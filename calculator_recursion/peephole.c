@@ -0,0 +1,390 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "peephole.h"
+
+#if REG_COUNT > 64
+#error "peephole keeps live registers in a 64 bit mask"
+#endif
+
+typedef unsigned long long RegMask;
+
+#define REG_BIT(r) (1ULL << (r))
+// r0, r1 and r2 are read by the simulator after `EXIT`
+#define LIVE_AT_EXIT (REG_BIT(0) | REG_BIT(1) | REG_BIT(2))
+
+/**
+ * Two adjacent instructions, a rule rewrites them in place
+ * @struct
+ */
+typedef struct {
+    IRInst* first;
+    IRInst* second;     // `NULL` at the end of the program
+    RegMask live_first;  // registers read after `first`
+    RegMask live_second; // registers read after `second`
+    int drop_first;
+    int drop_second;
+} PeepWindow;
+
+/**
+ * A rewrite, `apply` returns `1` when it changed the window
+ * @struct
+ */
+typedef struct {
+    const char* name;
+    int (*apply)(PeepWindow* w);
+} PeepRule;
+
+/**
+ * Registers live before `inst` when `live` are live after it
+ *
+ * @param inst
+ * @param live
+ */
+static RegMask ph_live_before(const IRInst* inst, RegMask live);
+
+static int ph_self_copy(PeepWindow* w);
+static int ph_dead_def(PeepWindow* w);
+static int ph_store_reload(PeepWindow* w);
+static int ph_reload_reload(PeepWindow* w);
+static int ph_identity(PeepWindow* w);
+static int ph_identity_fold(PeepWindow* w);
+static int ph_copy_forward(PeepWindow* w);
+static int ph_copy_back(PeepWindow* w);
+static int ph_three_address(PeepWindow* w);
+static int ph_immediate(PeepWindow* w);
+static int ph_memory(PeepWindow* w);
+
+static const PeepRule rules[] = {
+    { "self copy", ph_self_copy },           // MOV rA rA
+    { "dead def", ph_dead_def },             // rA written and never read
+    { "store reload", ph_store_reload },     // MOV [a] rB; MOV rC [a]    => MOV rC rB
+    { "reload reload", ph_reload_reload },   // MOV rB [a]; MOV rC [a]    => MOV rC rB
+    { "identity", ph_identity },             // MOV rA 0; ADD rX rA       => MOV rA 0
+    { "identity fold", ph_identity_fold },   // MOV rA 0; ADD rA rX       => MOV rA rX
+    { "copy forward", ph_copy_forward },     // MOV rA rB; OP rX rA       => OP rX rB
+    { "copy back", ph_copy_back },           // ADD rA rB; MOV rB rA      => ADD rB rA
+    { "three address", ph_three_address },   // MOV rT rL; SUB rT rR      => SUB rT rL rR
+    { "immediate operand", ph_immediate },   // MOV rA 5; SUB rX rA       => SUB rX 5
+    { "memory operand", ph_memory }          // MOV rA [a]; SUB rX rA     => SUB rX [a]
+};
+
+#define RULE_COUNT ((int)(sizeof(rules) / sizeof(rules[0])))
+
+static int ph_is_reg(IROperand op, int reg) {
+    return op.type == OPD_REG && op.value == reg;
+}
+
+static int ph_is_mov(const IRInst* inst, IROperandType dst, IROperandType src) {
+    return inst->opcode == IR_MOV && inst->op1.type == dst && inst->op2.type == src;
+}
+
+static RegMask ph_live_before(const IRInst* inst, RegMask live) {
+    if (ir_defines(inst))
+        live &= ~REG_BIT(inst->op1.value);
+    if (ir_reads_op1(inst) && inst->op1.type == OPD_REG)
+        live |= REG_BIT(inst->op1.value);
+    if (inst->op2.type == OPD_REG)
+        live |= REG_BIT(inst->op2.value);
+    if (inst->op3.type == OPD_REG)
+        live |= REG_BIT(inst->op3.value);
+    return live;
+}
+
+/**
+ * Whether `opcode` with the constant `k` on the right leaves the left operand unchanged
+ *
+ * @param opcode
+ * @param k
+ */
+static int ph_identity_of(IROpcode opcode, int k) {
+    switch (opcode) {
+    case IR_ADD:
+    case IR_SUB:
+    case IR_OR:
+    case IR_XOR:
+        return k == 0;
+    case IR_MUL:
+    case IR_DIV:
+        return k == 1;
+    case IR_AND:
+        return k == -1;
+    default:
+        return 0;
+    }
+}
+
+static int ph_two_address(const IRInst* inst) {
+    return inst->opcode != IR_MOV && inst->opcode != IR_EXIT && inst->op3.type == OPD_NONE;
+}
+
+static int ph_three_operands(const IRInst* inst) {
+    return inst->op3.type != OPD_NONE;
+}
+
+/**
+ * Right operand of an arithmetic instruction, `op3` in the 3-address form
+ *
+ * @param inst
+ */
+static IROperand* ph_rhs(IRInst* inst) {
+    return ph_three_operands(inst) ? &inst->op3 : &inst->op2;
+}
+
+static int ph_commutes(IROpcode opcode) {
+    return opcode == IR_ADD || opcode == IR_MUL || opcode == IR_AND || opcode == IR_OR || opcode == IR_XOR;
+}
+
+static int ph_self_copy(PeepWindow* w) {
+    if (!ph_is_mov(w->first, OPD_REG, OPD_REG) || w->first->op1.value != w->first->op2.value)
+        return 0;
+    w->drop_first = 1;
+    return 1;
+}
+
+static int ph_dead_def(PeepWindow* w) {
+    // a `DIV` by zero prints an error in the simulator, keep it
+    if (!ir_defines(w->first) || w->first->opcode == IR_DIV
+        || (w->live_first & REG_BIT(w->first->op1.value)))
+        return 0;
+    w->drop_first = 1;
+    return 1;
+}
+
+/**
+ * A read of `[a]` right after `[a]` went through `reg` reads `reg` instead
+ *
+ * @param w
+ * @param reg
+ */
+static int ph_forward_load(PeepWindow* w, int addr, int reg) {
+    if (!w->second)
+        return 0;
+    if (ph_is_mov(w->second, OPD_REG, OPD_ADDR) && w->second->op2.value == addr) {
+        if (w->second->op1.value == reg)
+            w->drop_second = 1;
+        else
+            w->second->op2 = IR_REG(reg);
+        return 1;
+    }
+    // ADD rX [a] from the memory operand extension
+    if (w->second->opcode != IR_MOV && w->second->opcode != IR_EXIT
+        && ph_rhs(w->second)->type == OPD_ADDR && ph_rhs(w->second)->value == addr) {
+        *ph_rhs(w->second) = IR_REG(reg);
+        return 1;
+    }
+    return 0;
+}
+
+static int ph_store_reload(PeepWindow* w) {
+    if (!ph_is_mov(w->first, OPD_ADDR, OPD_REG))
+        return 0;
+    return ph_forward_load(w, w->first->op1.value, w->first->op2.value);
+}
+
+static int ph_reload_reload(PeepWindow* w) {
+    if (!ph_is_mov(w->first, OPD_REG, OPD_ADDR))
+        return 0;
+    return ph_forward_load(w, w->first->op2.value, w->first->op1.value);
+}
+
+static int ph_identity(PeepWindow* w) {
+    // ADD rX 0
+    if (ph_two_address(w->first) && w->first->op2.type == OPD_CONST
+        && ph_identity_of(w->first->opcode, w->first->op2.value)) {
+        w->drop_first = 1;
+        return 1;
+    }
+    if (!w->second || !ph_is_mov(w->first, OPD_REG, OPD_CONST))
+        return 0;
+    int a = w->first->op1.value;
+    if (!ph_two_address(w->second) || !ph_is_reg(w->second->op2, a) || ph_is_reg(w->second->op1, a)
+        || !ph_identity_of(w->second->opcode, w->first->op2.value))
+        return 0;
+    w->drop_second = 1;
+    return 1;
+}
+
+static int ph_identity_fold(PeepWindow* w) {
+    if (!w->second || !ph_is_mov(w->first, OPD_REG, OPD_CONST))
+        return 0;
+    int a = w->first->op1.value;
+    IRInst* op = w->second;
+    // `0 - x` and `1 / x` are not `x`
+    if (!ph_two_address(op) || !ph_commutes(op->opcode) || !ph_is_reg(op->op1, a) || op->op2.type != OPD_REG
+        || op->op2.value == a || !ph_identity_of(op->opcode, w->first->op2.value))
+        return 0;
+    w->first->op2 = op->op2;
+    w->drop_second = 1;
+    return 1;
+}
+
+static int ph_copy_forward(PeepWindow* w) {
+    if (!w->second || !ph_is_mov(w->first, OPD_REG, OPD_REG))
+        return 0;
+    IRInst* second = w->second;
+    int a = w->first->op1.value;
+    // a 3-address instruction may overwrite `rA` after reading it
+    int redefines = ph_three_operands(second) && ph_is_reg(second->op1, a);
+    if (!(ph_is_reg(second->op2, a) || ph_is_reg(second->op3, a))
+        || (!ph_three_operands(second) && ph_is_reg(second->op1, a))
+        || (!redefines && (w->live_second & REG_BIT(a))))
+        return 0;
+    if (ph_is_reg(second->op2, a))
+        second->op2 = w->first->op2;
+    if (ph_is_reg(second->op3, a))
+        second->op3 = w->first->op2;
+    w->drop_first = 1;
+    return 1;
+}
+
+static int ph_copy_back(PeepWindow* w) {
+    if (!w->second || w->first->op1.type != OPD_REG || !ph_is_mov(w->second, OPD_REG, OPD_REG)
+        || w->first->opcode == IR_MOV || w->first->opcode == IR_EXIT)
+        return 0;
+    int a = w->first->op1.value;
+    int b = w->second->op1.value;
+    if (w->second->op2.value != a || a == b || (w->live_second & REG_BIT(a)))
+        return 0;
+    if (ph_three_operands(w->first)) {
+        // the result goes straight to `rB`
+        w->first->op1 = IR_REG(b);
+        w->drop_second = 1;
+        return 1;
+    }
+    if (!ph_commutes(w->first->opcode) || !ph_is_reg(w->first->op2, b))
+        return 0;
+    w->first->op1 = IR_REG(b);
+    w->first->op2 = IR_REG(a);
+    w->drop_second = 1;
+    return 1;
+}
+
+static int ph_three_address(PeepWindow* w) {
+    if (ir_target != TARGET_3ADDR || !w->second || !ph_is_mov(w->first, OPD_REG, OPD_REG)
+        || !ph_two_address(w->second))
+        return 0;
+    int t = w->first->op1.value;
+    if (!ph_is_reg(w->second->op1, t))
+        return 0;
+    // after the copy `rT` holds `rL`
+    w->second->op3 = ph_is_reg(w->second->op2, t) ? w->first->op2 : w->second->op2;
+    w->second->op2 = w->first->op2;
+    w->drop_first = 1;
+    return 1;
+}
+
+/**
+ * Fold the value `first` loads into the right operand of `second`
+ * when the extension allows it and it is cheaper by `ir_cycles()`
+ *
+ * @param w
+ * @param type `OPD_CONST` or `OPD_ADDR`
+ */
+static int ph_fold_operand(PeepWindow* w, IROperandType type) {
+    if (!w->second || !ph_is_mov(w->first, OPD_REG, type) || w->second->opcode == IR_MOV
+        || w->second->opcode == IR_EXIT)
+        return 0;
+    IRInst* second = w->second;
+    int a = w->first->op1.value;
+    IROperand* rhs = ph_rhs(second);
+    // `rA` must only be the right operand, and die there
+    if (!ph_is_reg(*rhs, a) || (ph_three_operands(second) ? ph_is_reg(second->op2, a) : ph_is_reg(second->op1, a))
+        || (w->live_second & REG_BIT(a)))
+        return 0;
+    IRInst folded = *second;
+    *ph_rhs(&folded) = w->first->op2;
+    if (ir_cycles(&folded) >= ir_cycles(w->first) + ir_cycles(second))
+        return 0;
+    *second = folded;
+    w->drop_first = 1;
+    return 1;
+}
+
+static int ph_immediate(PeepWindow* w) {
+    return (ir_extensions & IR_EXT_IMM) && ph_fold_operand(w, OPD_CONST);
+}
+
+static int ph_memory(PeepWindow* w) {
+    return (ir_extensions & IR_EXT_MEM) && ph_fold_operand(w, OPD_ADDR);
+}
+
+/**
+ * One backward sweep, the window slides from the end so liveness stays exact
+ *
+ * @param prog
+ * @param removed marks dropped instructions
+ * @param live live registers after each kept instruction
+ * @param next next kept instruction, or `-1`
+ * @param fired rewrites per rule
+ * @param saved cycles saved per rule
+ * @returns number of rewrites
+ */
+static int ph_sweep(IRProgram* prog, char* removed, RegMask* live, int* next, int* fired, int* saved) {
+    int changes = 0;
+    int after = -1;
+    for (int i = prog->size - 1; i >= 0; i--) {
+        if (removed[i])
+            continue;
+        for (int r = 0; r < RULE_COUNT; r++) {
+            PeepWindow w;
+            w.first = &prog->inst[i];
+            w.second = after >= 0 ? &prog->inst[after] : NULL;
+            w.live_second = after >= 0 ? live[after] : LIVE_AT_EXIT;
+            w.live_first = after >= 0 ? ph_live_before(w.second, w.live_second) : LIVE_AT_EXIT;
+            w.drop_first = w.drop_second = 0;
+
+            int before = ir_cycles(w.first) + (w.second ? ir_cycles(w.second) : 0);
+            if (!rules[r].apply(&w))
+                continue;
+            int cycles = (w.drop_first ? 0 : ir_cycles(w.first))
+                + (w.second && !w.drop_second ? ir_cycles(w.second) : 0);
+            fired[r]++;
+            saved[r] += before - cycles;
+            changes++;
+
+            if (w.drop_second) {
+                removed[after] = 1;
+                after = next[after];
+            }
+            if (w.drop_first) {
+                removed[i] = 1;
+                break;
+            }
+            // the window changed, try every rule again
+            r = -1;
+        }
+        if (removed[i])
+            continue;
+        next[i] = after;
+        live[i] = after >= 0 ? ph_live_before(&prog->inst[after], live[after]) : LIVE_AT_EXIT;
+        after = i;
+    }
+    return changes;
+}
+
+void peephole(IRProgram* prog, int report) {
+    char* removed = (char*)calloc(prog->size + 1, 1);
+    RegMask* live = (RegMask*)malloc((prog->size + 1) * sizeof(RegMask));
+    int* next = (int*)malloc((prog->size + 1) * sizeof(int));
+    int fired[RULE_COUNT] = { 0 };
+    int saved[RULE_COUNT] = { 0 };
+
+    while (ph_sweep(prog, removed, live, next, fired, saved))
+        ;
+
+    int size = 0;
+    for (int i = 0; i < prog->size; i++)
+        if (!removed[i])
+            prog->inst[size++] = prog->inst[i];
+    prog->size = size;
+
+    if (report)
+        for (int r = 0; r < RULE_COUNT; r++)
+            if (fired[r])
+                fprintf(stderr, "peephole %s: %d rewrites, %dcc saved\n", rules[r].name, fired[r], saved[r]);
+    free(removed);
+    free(live);
+    free(next);
+}
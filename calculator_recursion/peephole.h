@@ -0,0 +1,15 @@
+#ifndef __PEEPHOLE__
+#define __PEEPHOLE__
+
+#include "ir.h"
+
+/**
+ * Rewrite `prog` through a two-instruction window until no rule applies
+ * runs after `reg_alloc()`, every register operand must be physical
+ *
+ * @param prog
+ * @param report print how many cycles every rule saved on stderr
+ */
+extern void peephole(IRProgram* prog, int report);
+
+#endif // __PEEPHOLE__
@@ -0,0 +1,699 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "parser.h"
+#include "regAlloc.h"
+
+#define NO_COLOUR -1
+#define UNSPILLABLE INT_MAX
+
+/**
+ * Live interval of a vreg over the straight-line program
+ * it is written at `start` and read for the last time at `end`
+ * @struct
+ */
+typedef struct {
+    int start;
+    int end;
+    int uses;
+    int defs;
+    int restore; // cycles to get the value back after a spill
+    int colour;
+    int last_def;
+    int home;    // store `MOV [addr] v` after the last write, or `-1`
+    int home_uses;
+    int hint;    // source of `MOV v src` writing it first, its colour avoids the copy
+} Interval;
+
+/**
+ * `spill_set` values
+ * @enum
+ */
+typedef enum spill_kind_t {
+    SPILL_NONE,
+    SPILL_FULL, // every read and write goes through memory
+    SPILL_TAIL  // split at `home`, only the reads after it reload from the variable
+} SpillKind;
+
+/**
+ * How a spilled vreg gets its value back, per def segment
+ * @enum
+ */
+typedef enum value_kind_t {
+    VAL_TEMP,  // computed, only a slot keeps it
+    VAL_CONST, // `value` is an immediate, rematerialize with `MOV r imm`
+    VAL_HOME   // `value` is the address of an unmodified variable, reload it
+} ValueKind;
+
+typedef struct {
+    ValueKind kind;
+    int value;
+    int home_lost; // `[value]` was overwritten while the value is still needed
+    int def;       // instruction starting the current segment
+    int temp;      // vreg holding the value in the rewritten program
+    int temp_at;   // instruction `temp` was defined at, it may be read by the next one
+} SpillState;
+
+static Interval* iv = NULL;
+static char* spill_set = NULL;
+static char* unspillable = NULL;
+static int vreg_capacity = 0;
+
+/**
+ * Grow the per vreg tables to `prog->vreg_count`
+ *
+ * @param prog
+ */
+static void ra_reserve(const IRProgram* prog) {
+    if (prog->vreg_count <= vreg_capacity)
+        return;
+    int old = vreg_capacity;
+    vreg_capacity = prog->vreg_count * 2;
+    iv = (Interval*)realloc(iv, vreg_capacity * sizeof(Interval));
+    spill_set = (char*)realloc(spill_set, vreg_capacity);
+    unspillable = (char*)realloc(unspillable, vreg_capacity);
+    memset(unspillable + old, 0, vreg_capacity - old);
+}
+
+/**
+ * Call `fn` on the vreg operands of `inst`, reads before the write
+ *
+ * @param inst
+ * @param fn gets the vreg and whether it is read / written
+ * @param arg
+ */
+static void ra_operands(const IRInst* inst, void (*fn)(int vreg, int read, int write, void* arg), void* arg) {
+    if (inst->op2.type == OPD_VREG)
+        fn(inst->op2.value, 1, 0, arg);
+    if (inst->op1.type == OPD_VREG)
+        fn(inst->op1.value, ir_reads_op1(inst), ir_defines(inst), arg);
+}
+
+static void ra_touch(int v, int read, int write, void* arg) {
+    int at = *(int*)arg;
+    if (iv[v].start < 0)
+        iv[v].start = at;
+    if (iv[v].end < at)
+        iv[v].end = at;
+    iv[v].uses += read;
+    iv[v].defs += write;
+    if (read && iv[v].home >= 0 && at > iv[v].home)
+        iv[v].home_uses++;
+    if (write) {
+        iv[v].last_def = at;
+        iv[v].home = -1;
+    }
+}
+
+static void ra_intervals(const IRProgram* prog) {
+    ra_reserve(prog);
+    for (int v = 0; v < prog->vreg_count; v++)
+        iv[v] = (Interval){ -1, -1, 0, 0, 2 * CC_MOV_MEM, NO_COLOUR, -1, -1, 0, -1 };
+    for (int i = 0; i < prog->size; i++) {
+        ra_operands(&prog->inst[i], ra_touch, &i);
+        const IRInst* inst = &prog->inst[i];
+        // a single `MOV v imm` / `MOV v [addr]` is cheap to get back
+        if (inst->opcode == IR_MOV && inst->op1.type == OPD_VREG) {
+            int v = inst->op1.value;
+            if (iv[v].defs == 1 && inst->op2.type == OPD_VREG)
+                iv[v].hint = inst->op2.value;
+            if (iv[v].defs == 1 && inst->op2.type == OPD_CONST)
+                iv[v].restore = CC_MOV_REG;
+            else if (iv[v].defs == 1 && inst->op2.type == OPD_ADDR)
+                iv[v].restore = CC_MOV_MEM;
+            else
+                iv[v].restore = 2 * CC_MOV_MEM;
+        } else if (ir_defines(inst) && inst->op1.type == OPD_VREG)
+            iv[inst->op1.value].restore = 2 * CC_MOV_MEM;
+        // once stored to a variable the value can come back from there
+        if (inst->opcode == IR_MOV && inst->op1.type == OPD_ADDR && inst->op2.type == OPD_VREG
+            && iv[inst->op2.value].home < 0) {
+            iv[inst->op2.value].home = i;
+            iv[inst->op2.value].home_uses = 0;
+        }
+    }
+
+    // a home overwritten before the last read is useless
+    int* next_store = (int*)malloc((prog->size + 1) * sizeof(int));
+    int* last_store = (int*)malloc(mem_words * sizeof(int));
+    for (int w = 0; w < mem_words; w++)
+        last_store[w] = INT_MAX;
+    for (int i = prog->size - 1; i >= 0; i--) {
+        const IRInst* inst = &prog->inst[i];
+        next_store[i] = INT_MAX;
+        if (inst->opcode == IR_MOV && inst->op1.type == OPD_ADDR) {
+            next_store[i] = last_store[inst->op1.value / 4];
+            last_store[inst->op1.value / 4] = i;
+        }
+    }
+    for (int v = 0; v < prog->vreg_count; v++)
+        if (iv[v].home >= 0 && next_store[iv[v].home] < iv[v].end)
+            iv[v].home = -1;
+    free(next_store);
+    free(last_store);
+}
+
+/**
+ * Whether spilling `v` only from its home store on shortens the interval
+ *
+ * @param v
+ * @param at where registers run out, `-1` when unknown
+ */
+static int ra_splits(int v, int at) {
+    return iv[v].home >= 0 && iv[v].home < iv[v].end && (at < 0 || iv[v].home <= at);
+}
+
+/**
+ * Cycles lost per instruction of the interval if `v` lives in memory
+ * the allocators spill the lowest weight first
+ *
+ * @param v
+ * @param at where registers run out, `-1` when unknown
+ */
+static int ra_weight(int v, int at) {
+    // spilling a vreg that spans at most two instructions gains nothing
+    if (unspillable[v] || iv[v].end - iv[v].start <= 1)
+        return UNSPILLABLE;
+    if (ra_splits(v, at))
+        return (int)((long long)iv[v].home_uses * CC_MOV_MEM * 16 / (iv[v].end - iv[v].home + 1));
+    return (int)((long long)iv[v].uses * iv[v].restore * 16 / (iv[v].end - iv[v].start + 1));
+}
+
+static void ra_spill(int v, int at) {
+    spill_set[v] = ra_splits(v, at) ? SPILL_TAIL : SPILL_FULL;
+}
+
+static int ra_interferes(int u, int v) {
+    return iv[u].start < iv[v].end && iv[v].start < iv[u].end;
+}
+
+static int ra_by_start(const void* a, const void* b) {
+    return iv[*(const int*)a].start - iv[*(const int*)b].start;
+}
+
+/**
+ * Live vregs sorted by `start`
+ *
+ * @param prog
+ * @param order filled with vreg numbers
+ * @returns count of live vregs
+ */
+static int ra_order(const IRProgram* prog, int* order) {
+    int n = 0;
+    for (int v = 0; v < prog->vreg_count; v++)
+        if (iv[v].start >= 0)
+            order[n++] = v;
+    qsort(order, n, sizeof(int), ra_by_start);
+    return n;
+}
+
+/**
+ * Free register for `v`, the one of its copy source first
+ *
+ * @param v
+ * @param used
+ * @returns colour or `NO_COLOUR`
+ */
+static int ra_pick(int v, const int* used) {
+    int hint = iv[v].hint >= 0 ? iv[iv[v].hint].colour : NO_COLOUR;
+    if (hint != NO_COLOUR && !used[hint])
+        return hint;
+    for (int r = 0; r < REG_COUNT; r++)
+        if (!used[r])
+            return r;
+    return NO_COLOUR;
+}
+
+/**
+ * Poletto-Sarkar linear scan, on pressure spill the lowest `ra_weight()`
+ *
+ * @param prog
+ * @returns count of spilled vregs
+ */
+static int ra_linear_scan(const IRProgram* prog) {
+    int* order = (int*)malloc(prog->vreg_count * sizeof(int));
+    int n = ra_order(prog, order);
+    int active[REG_COUNT];
+    int active_count = 0;
+    int spilled = 0;
+
+    for (int k = 0; k < n; k++) {
+        int v = order[k];
+        int used[REG_COUNT] = { 0 };
+
+        // registers whose last read is at or before this write are free again
+        for (int i = 0; i < active_count;)
+            if (iv[active[i]].end <= iv[v].start)
+                active[i] = active[--active_count];
+            else
+                used[iv[active[i++]].colour] = 1;
+
+        if (active_count < REG_COUNT) {
+            iv[v].colour = ra_pick(v, used);
+            active[active_count++] = v;
+            continue;
+        }
+
+        int at = iv[v].start;
+        int victim = -1;
+        for (int i = 0; i < active_count; i++)
+            if (victim < 0 || ra_weight(active[i], at) < ra_weight(active[victim], at))
+                victim = i;
+        if (ra_weight(v, at) <= ra_weight(active[victim], at)) {
+            if (ra_weight(v, at) == UNSPILLABLE)
+                error(RUNOUT, "Too few registers for the spill code");
+            ra_spill(v, at);
+        } else {
+            ra_spill(active[victim], at);
+            iv[v].colour = iv[active[victim]].colour;
+            active[victim] = v;
+        }
+        spilled++;
+    }
+    free(order);
+    return spilled;
+}
+
+static void ra_adjacent(int** adj, int* size, int* cap, int u, int v) {
+    if (size[u] == cap[u]) {
+        cap[u] = cap[u] ? cap[u] * 2 : 8;
+        adj[u] = (int*)realloc(adj[u], cap[u] * sizeof(int));
+    }
+    adj[u][size[u]++] = v;
+}
+
+/**
+ * Chaitin-Briggs colouring of the interference graph with optimistic spilling
+ *
+ * @param prog
+ * @returns count of spilled vregs
+ */
+static int ra_graph_colour(const IRProgram* prog) {
+    int* order = (int*)malloc(prog->vreg_count * sizeof(int));
+    int n = ra_order(prog, order);
+    int* degree = (int*)calloc(prog->vreg_count, sizeof(int));
+    int** adj = (int**)calloc(prog->vreg_count, sizeof(int*));
+    int* adj_size = (int*)calloc(prog->vreg_count, sizeof(int));
+    int* adj_cap = (int*)calloc(prog->vreg_count, sizeof(int));
+    int* active = (int*)malloc((n ? n : 1) * sizeof(int));
+    int active_count = 0;
+
+    // build: sweep the intervals, everything still live at a write interferes with it
+    for (int k = 0; k < n; k++) {
+        int v = order[k];
+        for (int i = 0; i < active_count;)
+            if (iv[active[i]].end <= iv[v].start)
+                active[i] = active[--active_count];
+            else {
+                int u = active[i++];
+                if (!ra_interferes(u, v))
+                    continue;
+                ra_adjacent(adj, adj_size, adj_cap, u, v);
+                ra_adjacent(adj, adj_size, adj_cap, v, u);
+            }
+        active[active_count++] = v;
+    }
+
+    // simplify: remove trivially colourable nodes, else push the cheapest spill candidate
+    int* stack = (int*)malloc((n ? n : 1) * sizeof(int));
+    char* removed = (char*)calloc(prog->vreg_count, 1);
+    int* queue = (int*)malloc((n ? n : 1) * sizeof(int));
+    int head = 0, tail = 0, top = 0;
+    for (int k = 0; k < n; k++) {
+        degree[order[k]] = adj_size[order[k]];
+        if (degree[order[k]] < REG_COUNT)
+            queue[tail++] = order[k];
+    }
+    while (top < n) {
+        int v = -1;
+        while (head < tail && v < 0)
+            if (!removed[queue[head++]])
+                v = queue[head - 1];
+        if (v < 0) {
+            long long best = LLONG_MAX;
+            for (int k = 0; k < n; k++) {
+                int u = order[k];
+                long long cost = ra_weight(u, -1) == UNSPILLABLE
+                    ? LLONG_MAX - 1
+                    : (long long)ra_weight(u, -1) * 1024 / (degree[u] + 1);
+                if (!removed[u] && cost < best) {
+                    best = cost;
+                    v = u;
+                }
+            }
+        }
+        removed[v] = 1;
+        stack[top++] = v;
+        for (int i = 0; i < adj_size[v]; i++) {
+            int u = adj[v][i];
+            if (!removed[u] && --degree[u] == REG_COUNT - 1)
+                queue[tail++] = u;
+        }
+    }
+
+    // select: colour in reverse removal order, spill what cannot be coloured
+    int spilled = 0;
+    while (top > 0) {
+        int v = stack[--top];
+        int used[REG_COUNT] = { 0 };
+        for (int i = 0; i < adj_size[v]; i++)
+            if (iv[adj[v][i]].colour != NO_COLOUR)
+                used[iv[adj[v][i]].colour] = 1;
+        iv[v].colour = ra_pick(v, used);
+        if (iv[v].colour == NO_COLOUR) {
+            if (ra_weight(v, -1) == UNSPILLABLE)
+                error(RUNOUT, "Too few registers for the spill code");
+            ra_spill(v, -1);
+            spilled++;
+        }
+    }
+
+    for (int k = 0; k < n; k++)
+        free(adj[order[k]]);
+    free(adj);
+    free(adj_size);
+    free(adj_cap);
+    free(degree);
+    free(active);
+    free(stack);
+    free(removed);
+    free(queue);
+    free(order);
+    return spilled;
+}
+
+/**
+ * Walk the value of spilled vreg `v` through instruction `i`
+ * decide whether the read at `i` reuses the temp, rematerializes, reloads from home or from the slot
+ *
+ * @returns the `IROrigin` of the reload, `ORIGIN_CODE` when the temp is reused
+ */
+static IROrigin ra_spill_read(const SpillState* st, int i, int write) {
+    // the temp written by the previous instruction is still in its register
+    if (st->temp_at == i - 1 && st->def == i - 1 && !write)
+        return ORIGIN_CODE;
+    if (st->kind == VAL_CONST)
+        return ORIGIN_REMAT;
+    if (st->kind == VAL_HOME && !st->home_lost)
+        return ORIGIN_HOME;
+    return ORIGIN_RELOAD;
+}
+
+static void ra_spill_write(SpillState* st, const IRInst* inst, int i) {
+    st->def = i;
+    st->home_lost = 0;
+    if (inst->opcode == IR_MOV && inst->op2.type == OPD_CONST)
+        *st = (SpillState){ VAL_CONST, inst->op2.value, 0, i, st->temp, st->temp_at };
+    else if (inst->opcode == IR_MOV && inst->op2.type == OPD_ADDR)
+        *st = (SpillState){ VAL_HOME, inst->op2.value, 0, i, st->temp, st->temp_at };
+    else
+        st->kind = VAL_TEMP;
+}
+
+/**
+ * Track stores to variables: a stored temp can be reloaded from there,
+ * a variable overwritten by something else is no longer a home
+ */
+static void ra_spill_store(SpillState* state, const IRInst* inst, const int* spilled, int spilled_count) {
+    if (inst->opcode != IR_MOV || inst->op1.type != OPD_ADDR)
+        return;
+    for (int k = 0; k < spilled_count; k++) {
+        int v = spilled[k];
+        if (inst->op2.type == OPD_VREG && inst->op2.value == v) {
+            if (state[v].kind == VAL_TEMP)
+                state[v] = (SpillState){ VAL_HOME, inst->op1.value, 0, state[v].def, state[v].temp, state[v].temp_at };
+        } else if (state[v].kind == VAL_HOME && state[v].value == inst->op1.value)
+            state[v].home_lost = 1;
+    }
+}
+
+/**
+ * Rewrite every spilled vreg into short temps around its reads and writes
+ *
+ * @param prog
+ */
+static void ra_rewrite(IRProgram* prog) {
+    SpillState* state = (SpillState*)malloc(vreg_capacity * sizeof(SpillState));
+    char* needs_store = (char*)calloc(prog->size + 1, 1);
+    int* spilled = (int*)malloc(vreg_capacity * sizeof(int));
+    int spilled_count = 0;
+    for (int v = 0; v < vreg_capacity; v++)
+        if (v < prog->vreg_count && spill_set[v] == SPILL_FULL)
+            spilled[spilled_count++] = v;
+        else if (v >= prog->vreg_count)
+            spill_set[v] = SPILL_NONE;
+
+    // pass 1: find the writes whose value must be kept in a slot
+    for (int v = 0; v < vreg_capacity; v++)
+        state[v] = (SpillState){ VAL_TEMP, 0, 0, -2, -1, -2 };
+    for (int i = 0; i < prog->size; i++) {
+        IRInst* inst = &prog->inst[i];
+        int ops[2] = { inst->op2.type == OPD_VREG ? inst->op2.value : -1,
+                       inst->op1.type == OPD_VREG ? inst->op1.value : -1 };
+        for (int k = 0; k < 2; k++) {
+            int v = ops[k];
+            int read = k == 0 || ir_reads_op1(inst);
+            if (v < 0 || spill_set[v] != SPILL_FULL || !read || (k == 1 && ops[0] == v))
+                continue;
+            if (ra_spill_read(&state[v], i, k == 1 && ir_defines(inst)) == ORIGIN_RELOAD)
+                needs_store[state[v].def] = 1;
+        }
+        ra_spill_store(state, inst, spilled, spilled_count);
+        if (ops[1] >= 0 && spill_set[ops[1]] == SPILL_FULL && ir_defines(inst)) {
+            ra_spill_write(&state[ops[1]], inst, i);
+            state[ops[1]].temp_at = i;
+        }
+    }
+
+    // pass 2: emit the reloads and stores
+    IRProgram out = { NULL, 0, 0, prog->vreg_count };
+    for (int v = 0; v < vreg_capacity; v++)
+        state[v] = (SpillState){ VAL_TEMP, 0, 0, -2, -1, -2 };
+    for (int i = 0; i < prog->size; i++) {
+        IRInst inst = prog->inst[i];
+        int ops[2] = { inst.op2.type == OPD_VREG ? inst.op2.value : -1,
+                       inst.op1.type == OPD_VREG ? inst.op1.value : -1 };
+        int temps[2] = { -1, -1 };
+        for (int k = 0; k < 2; k++) {
+            int v = ops[k];
+            if (v < 0 || !spill_set[v])
+                continue;
+            if (spill_set[v] == SPILL_TAIL) {
+                // split: the value is reloaded from the variable it was stored to
+                if (i > iv[v].home) {
+                    temps[k] = out.vreg_count++;
+                    ir_push(&out, (IRInst){ .opcode = IR_MOV, .op1 = IR_VREG(temps[k]), .op2 = prog->inst[iv[v].home].op1, .stmt = inst.stmt, .origin = ORIGIN_HOME, .op3 = IR_NONE });
+                }
+                continue;
+            }
+            if (k == 1 && ops[0] == v) {
+                temps[1] = temps[0];
+                continue;
+            }
+            int read = k == 0 || ir_reads_op1(&inst);
+            if (!read) {
+                temps[k] = out.vreg_count++;
+                continue;
+            }
+            IROrigin origin = ra_spill_read(&state[v], i, k == 1 && ir_defines(&inst));
+            if (origin == ORIGIN_CODE) {
+                temps[k] = state[v].temp;
+                continue;
+            }
+            temps[k] = out.vreg_count++;
+            IROperand src = origin == ORIGIN_REMAT
+                ? IR_CONST(state[v].value)
+                : origin == ORIGIN_HOME
+                ? IR_ADDR(state[v].value)
+                : (IROperand){ OPD_SLOT, v };
+            ir_push(&out, (IRInst){ .opcode = IR_MOV, .op1 = IR_VREG(temps[k]), .op2 = src, .stmt = inst.stmt, .origin = origin, .op3 = IR_NONE });
+        }
+        if (temps[0] >= 0)
+            inst.op2 = IR_VREG(temps[0]);
+        if (temps[1] >= 0)
+            inst.op1 = IR_VREG(temps[1]);
+        ir_push(&out, inst);
+        ra_spill_store(state, &prog->inst[i], spilled, spilled_count);
+        if (ops[1] >= 0 && spill_set[ops[1]] == SPILL_FULL && ir_defines(&inst)) {
+            int v = ops[1];
+            ra_spill_write(&state[v], &prog->inst[i], i);
+            state[v].temp = temps[1];
+            state[v].temp_at = i;
+            if (needs_store[i])
+                ir_push(&out, (IRInst){ .opcode = IR_MOV, .op1 = (IROperand){ OPD_SLOT, v }, .op2 = IR_VREG(temps[1]), .stmt = inst.stmt, .origin = ORIGIN_STORE, .op3 = IR_NONE });
+        }
+    }
+
+    ra_reserve(&out);
+    for (int v = prog->vreg_count; v < out.vreg_count; v++)
+        unspillable[v] = 1;
+    free(prog->inst);
+    *prog = out;
+    free(state);
+    free(needs_store);
+    free(spilled);
+}
+
+// representative of `v` after coalescing, compressing the path on the way
+static int ra_find(int* rep, int v) {
+    while (rep[v] != v)
+        v = rep[v] = rep[rep[v]];
+    return v;
+}
+
+/**
+ * Merge `MOV t a` into `a` when `a` is read for the last time there
+ *
+ * @param prog
+ * @returns count of removed copies
+ */
+static int ra_coalesce(IRProgram* prog) {
+    int* rep = (int*)malloc(prog->vreg_count * sizeof(int));
+    int removed = 0;
+    ra_intervals(prog);
+    for (int v = 0; v < prog->vreg_count; v++)
+        rep[v] = v;
+
+    int size = 0;
+    for (int i = 0; i < prog->size; i++) {
+        IRInst inst = prog->inst[i];
+        if (inst.op1.type == OPD_VREG)
+            inst.op1.value = ra_find(rep, inst.op1.value);
+        if (inst.op2.type == OPD_VREG)
+            inst.op2.value = ra_find(rep, inst.op2.value);
+        if (inst.opcode == IR_MOV && inst.op1.type == OPD_VREG && inst.op2.type == OPD_VREG) {
+            int t = inst.op1.value;
+            int a = inst.op2.value;
+            // values kept across statements are not merged into temporaries, else
+            // spilling the merged vreg would have to store the whole chain
+            if (t != a && iv[a].end == i && iv[t].start == i
+                && prog->inst[iv[a].start].stmt == inst.stmt) {
+                // every later mention of `t` is renamed to `a`, which now lives until `t` dies
+                rep[t] = a;
+                iv[a].end = iv[t].end;
+                removed++;
+                continue;
+            }
+        }
+        prog->inst[size++] = inst;
+    }
+    prog->size = size;
+    free(rep);
+    return removed;
+}
+
+// the spill slot operand of `inst`, `NULL` when it has none
+static IROperand* ra_slot_operand(IRInst* inst) {
+    return inst->op1.type == OPD_SLOT ? &inst->op1
+        : inst->op2.type == OPD_SLOT ? &inst->op2
+        : NULL;
+}
+
+/**
+ * Give every spill slot a word right after the variables, the lowest one free,
+ * reusing words of dead slots
+ *
+ * @param prog
+ */
+static void ra_slots(IRProgram* prog) {
+    int* last = (int*)malloc(vreg_capacity * sizeof(int));
+    int* word = (int*)malloc(vreg_capacity * sizeof(int));
+    int* active = (int*)malloc(vreg_capacity * sizeof(int));
+    int active_count = 0;
+    char* used = (char*)calloc(mem_words, 1);
+    for (int v = 0; v < vreg_capacity; v++)
+        last[v] = word[v] = -1;
+    for (int i = 0; i < prog->size; i++) {
+        IROperand* op = ra_slot_operand(&prog->inst[i]);
+        if (op)
+            last[op->value] = i;
+    }
+    for (int i = 0; i < prog->size; i++) {
+        IROperand* op = ra_slot_operand(&prog->inst[i]);
+        if (!op)
+            continue;
+        int s = op->value;
+        if (word[s] < 0) {
+            // a slot is dead after its last reload, its word can be reused
+            for (int k = 0; k < active_count;)
+                if (last[active[k]] < i) {
+                    used[word[active[k]]] = 0;
+                    active[k] = active[--active_count];
+                } else
+                    k++;
+            for (int w = sbcount; word[s] < 0; w++) {
+                if (w >= mem_words)
+                    error(RUNOUT, "Spill slots run out of memory");
+                if (!used[w]) {
+                    used[w] = 1;
+                    word[s] = w;
+                }
+            }
+            active[active_count++] = s;
+        }
+        *op = IR_ADDR(word[s] * 4);
+    }
+    free(last);
+    free(word);
+    free(active);
+    free(used);
+}
+
+static void ra_report(const IRProgram* prog, int coalesced) {
+    int stmts = 0;
+    for (int i = 0; i < prog->size; i++)
+        if (prog->inst[i].stmt > stmts)
+            stmts = prog->inst[i].stmt;
+    int (*count)[ORIGIN_HOME + 1] = calloc(stmts + 1, sizeof(*count));
+    int* cycles = (int*)calloc(stmts + 1, sizeof(int));
+    for (int i = 0; i < prog->size; i++) {
+        const IRInst* inst = &prog->inst[i];
+        count[inst->stmt][inst->origin]++;
+        if (inst->origin != ORIGIN_CODE)
+            cycles[inst->stmt] += inst->origin == ORIGIN_REMAT ? CC_MOV_REG : CC_MOV_MEM;
+    }
+    int total = 0;
+    fprintf(stderr, "coalesced %d copies\n", coalesced);
+    for (int s = 1; s <= stmts; s++)
+        if (cycles[s] > 0) {
+            fprintf(stderr, "statement %d: spill %d store, %d reload, %d remat, %d home reload, %dcc\n",
+                s, count[s][ORIGIN_STORE], count[s][ORIGIN_RELOAD], count[s][ORIGIN_REMAT],
+                count[s][ORIGIN_HOME], cycles[s]);
+            total += cycles[s];
+        }
+    fprintf(stderr, "spill total: %dcc with %d registers\n", total, REG_COUNT);
+    free(count);
+    free(cycles);
+}
+
+void reg_alloc(IRProgram* prog, int graph_colouring, int report) {
+    int coalesced = ra_coalesce(prog);
+    for (;;) {
+        ra_intervals(prog);
+        memset(spill_set, 0, vreg_capacity);
+        int spilled = graph_colouring ? ra_graph_colour(prog) : ra_linear_scan(prog);
+        if (!spilled)
+            break;
+        ra_rewrite(prog);
+    }
+    ra_slots(prog);
+
+    // bind the colours, copies between the same register are dropped
+    int size = 0;
+    for (int i = 0; i < prog->size; i++) {
+        IRInst inst = prog->inst[i];
+        if (inst.op1.type == OPD_VREG)
+            inst.op1 = IR_REG(iv[inst.op1.value].colour);
+        if (inst.op2.type == OPD_VREG)
+            inst.op2 = IR_REG(iv[inst.op2.value].colour);
+        if (inst.opcode == IR_MOV && inst.op1.type == OPD_REG && inst.op2.type == OPD_REG
+            && inst.op1.value == inst.op2.value)
+            continue;
+        prog->inst[size++] = inst;
+    }
+    prog->size = size;
+
+    if (report)
+        ra_report(prog, coalesced);
+}
@@ -0,0 +1,18 @@
+#ifndef __REGALLOC__
+#define __REGALLOC__
+
+#include "ir.h"
+
+/**
+ * Map every vreg of `prog` onto `r0..r{REG_COUNT-1}`
+ * copies whose source dies are coalesced first, then vregs are allocated and
+ * spilled until everything fits; constants are rematerialized, unmodified
+ * variables reloaded from home, and only temporaries get a spill slot
+ *
+ * @param prog
+ * @param graph_colouring `0` for linear scan, `1` for Chaitin-Briggs colouring
+ * @param report print per statement spill costs on stderr
+ */
+extern void reg_alloc(IRProgram* prog, int graph_colouring, int report);
+
+#endif // __REGALLOC__
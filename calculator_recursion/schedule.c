@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "schedule.h"
+#include "../assembly_parser/analyze.h"
+
+/**
+ * Dependence between two instructions of a statement
+ * `to` may issue `latency` cycles after `from` at the earliest, and never before it
+ * @struct
+ */
+typedef struct {
+    int to;
+    int latency;
+} SchedEdge;
+
+/**
+ * One instruction of the statement being scheduled
+ * @struct
+ */
+typedef struct {
+    SchedEdge* succ;
+    int succ_count;
+    int succ_capacity;
+    int preds;    // predecessors not scheduled yet
+    int height;   // cycles from its issue to the end of the statement on the longest path
+    int earliest; // first cycle its operands are ready
+} SchedNode;
+
+/**
+ * Issue state of the in-order pipeline, same model as the simulator's `-p`
+ * @struct
+ */
+typedef struct {
+    int width;
+    int cycle;
+    int issued;
+    int mem_issued;
+} SchedPipe;
+
+static int sc_accesses_memory(const IRInst* inst) {
+    return inst->op1.type == OPD_ADDR || inst->op2.type == OPD_ADDR || inst->op3.type == OPD_ADDR;
+}
+
+/**
+ * Whether `inst` reads the register `reg`
+ *
+ * @param inst
+ * @param reg
+ */
+static int sc_reads(const IRInst* inst, int reg) {
+    return (ir_reads_op1(inst) && inst->op1.type == OPD_REG && inst->op1.value == reg)
+        || (inst->op2.type == OPD_REG && inst->op2.value == reg)
+        || (inst->op3.type == OPD_REG && inst->op3.value == reg);
+}
+
+/**
+ * Whether `inst` reads the word at `addr`
+ *
+ * @param inst
+ * @param addr
+ */
+static int sc_loads(const IRInst* inst, int addr) {
+    return (inst->op2.type == OPD_ADDR && inst->op2.value == addr)
+        || (inst->op3.type == OPD_ADDR && inst->op3.value == addr);
+}
+
+/**
+ * Minimal latency from `a` to the later `b`, or `-1` when they are independent
+ *
+ * @param a
+ * @param b
+ */
+static int sc_latency(const IRInst* a, const IRInst* b) {
+    if (b->opcode == IR_EXIT)
+        return 0;
+    int a_writes = ir_defines(a) ? a->op1.value : -1;
+    int b_writes = ir_defines(b) ? b->op1.value : -1;
+    // read after write and write after write wait for the result
+    if (a_writes >= 0 && (sc_reads(b, a_writes) || b_writes == a_writes))
+        return ir_cycles(a);
+    if (a->op1.type == OPD_ADDR && sc_loads(b, a->op1.value))
+        return ir_cycles(a);
+    // write after read only keeps the order
+    if (b_writes >= 0 && sc_reads(a, b_writes))
+        return 0;
+    if (b->op1.type == OPD_ADDR && (sc_loads(a, b->op1.value)
+        || (a->op1.type == OPD_ADDR && a->op1.value == b->op1.value)))
+        return 0;
+    return -1;
+}
+
+static void sc_add_edge(SchedNode* node, int to, int latency) {
+    if (node->succ_count == node->succ_capacity) {
+        node->succ_capacity = node->succ_capacity ? node->succ_capacity * 2 : 4;
+        node->succ = (SchedEdge*)realloc(node->succ, node->succ_capacity * sizeof(SchedEdge));
+    }
+    node->succ[node->succ_count++] = (SchedEdge){ to, latency };
+}
+
+/**
+ * Cycle `inst` can issue in when its operands are ready at `earliest`, then issue it
+ *
+ * @param pipe
+ * @param inst
+ * @param earliest
+ */
+static int sc_issue(SchedPipe* pipe, const IRInst* inst, int earliest) {
+    int t = earliest > pipe->cycle ? earliest : pipe->cycle;
+    int is_mem = sc_accesses_memory(inst);
+    if (t == pipe->cycle && (pipe->issued == pipe->width || (is_mem && pipe->mem_issued == PIPE_MEM_PORTS)))
+        t++;
+    if (t != pipe->cycle) {
+        pipe->cycle = t;
+        pipe->issued = pipe->mem_issued = 0;
+    }
+    pipe->issued++;
+    if (is_mem)
+        pipe->mem_issued++;
+    return t;
+}
+
+/**
+ * Whether `inst` could issue in the current cycle once ready
+ *
+ * @param pipe
+ * @param inst
+ */
+static int sc_has_slot(const SchedPipe* pipe, const IRInst* inst) {
+    return pipe->issued < pipe->width && (!sc_accesses_memory(inst) || pipe->mem_issued < PIPE_MEM_PORTS);
+}
+
+/**
+ * Pipelined cycles of the whole program, from the simulator's own analysis
+ *
+ * @param prog
+ * @param width
+ */
+static int sc_estimate(const IRProgram* prog, int width) {
+    ANALYSIS a;
+    ir_analyze(prog, width, 0, mem_words, &a);
+    int finish = a.pipe.finish;
+    analyze_free(&a);
+    return finish;
+}
+
+/**
+ * Reorder `inst[begin, end)`, a single statement, into `out`
+ *
+ * @param inst
+ * @param begin
+ * @param end
+ * @param width
+ * @param out
+ */
+static void sc_block(const IRInst* inst, int begin, int end, int width, IRInst* out) {
+    int n = end - begin;
+    SchedNode* node = (SchedNode*)calloc(n, sizeof(SchedNode));
+    char* done = (char*)calloc(n, 1);
+    for (int i = 0; i < n; i++)
+        for (int j = i + 1; j < n; j++) {
+            int latency = sc_latency(&inst[begin + i], &inst[begin + j]);
+            if (latency >= 0) {
+                sc_add_edge(&node[i], j, latency);
+                node[j].preds++;
+            }
+        }
+    // edges only go forward, heights are final when walking backwards
+    for (int i = n - 1; i >= 0; i--) {
+        node[i].height = ir_cycles(&inst[begin + i]);
+        for (int e = 0; e < node[i].succ_count; e++) {
+            int h = node[i].succ[e].latency + node[node[i].succ[e].to].height;
+            if (h > node[i].height)
+                node[i].height = h;
+        }
+    }
+
+    SchedPipe pipe = { width, 0, 0, 0 };
+    for (int k = 0; k < n; k++) {
+        // the tallest ready instruction that can issue now, else the one ready first
+        int pick = -1, wait = -1;
+        for (int i = 0; i < n; i++) {
+            if (done[i] || node[i].preds)
+                continue;
+            if (node[i].earliest <= pipe.cycle && sc_has_slot(&pipe, &inst[begin + i])) {
+                if (pick < 0 || node[i].height > node[pick].height)
+                    pick = i;
+            } else if (wait < 0 || node[i].earliest < node[wait].earliest
+                || (node[i].earliest == node[wait].earliest && node[i].height > node[wait].height))
+                wait = i;
+        }
+        if (pick < 0)
+            pick = wait;
+        int t = sc_issue(&pipe, &inst[begin + pick], node[pick].earliest);
+        done[pick] = 1;
+        out[k] = inst[begin + pick];
+        for (int e = 0; e < node[pick].succ_count; e++) {
+            SchedNode* succ = &node[node[pick].succ[e].to];
+            succ->preds--;
+            if (t + node[pick].succ[e].latency > succ->earliest)
+                succ->earliest = t + node[pick].succ[e].latency;
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+        free(node[i].succ);
+    free(node);
+    free(done);
+}
+
+void schedule(IRProgram* prog, int width, int report) {
+    int before = report ? sc_estimate(prog, width) : 0;
+    IRInst* out = (IRInst*)malloc((prog->size + 1) * sizeof(IRInst));
+    for (int begin = 0, end; begin < prog->size; begin = end) {
+        for (end = begin + 1; end < prog->size && prog->inst[end].stmt == prog->inst[begin].stmt; end++)
+            ;
+        sc_block(prog->inst, begin, end, width, out + begin);
+    }
+    memcpy(prog->inst, out, prog->size * sizeof(IRInst));
+    free(out);
+    if (report)
+        fprintf(stderr, "schedule: %d pipelined cycles before, %d after (issue width %d)\n",
+            before, sc_estimate(prog, width), width);
+}
@@ -0,0 +1,17 @@
+#ifndef __SCHEDULE__
+#define __SCHEDULE__
+
+#include "ir.h"
+
+/**
+ * List-schedule the instructions of every statement for the simulator's pipelined
+ * timing model, independent loads and arithmetic are interleaved to hide latency
+ * runs after `peephole()`, every register operand must be physical
+ *
+ * @param prog
+ * @param width instructions issued per cycle
+ * @param report print the estimated pipelined cycles before and after on stderr
+ */
+extern void schedule(IRProgram* prog, int width, int report);
+
+#endif // __SCHEDULE__
@@ -1,5 +1,5 @@
 # source files
-$SourceFiles = "./calculator_recursion/lex.h", "./calculator_recursion/lex.c", "./calculator_recursion/parser.h", "./calculator_recursion/parser.c", "./calculator_recursion/codeGen.h", "./calculator_recursion/codeGen.c", "./calculator_recursion/main.c"
+$SourceFiles = "./calculator_recursion/lex.h", "./calculator_recursion/lex.c", "./calculator_recursion/parser.h", "./calculator_recursion/parser.c", "./calculator_recursion/ir.h", "./calculator_recursion/ir.c", "./calculator_recursion/regAlloc.h", "./calculator_recursion/regAlloc.c", "./calculator_recursion/peephole.h", "./calculator_recursion/peephole.c", "./calculator_recursion/instSelect.h", "./calculator_recursion/instSelect.c", "./calculator_recursion/schedule.h", "./calculator_recursion/schedule.c", "./calculator_recursion/layout.h", "./calculator_recursion/layout.c", "./calculator_recursion/codeGen.h", "./calculator_recursion/codeGen.c", "./calculator_recursion/main.c", "./calculator_recursion/api.h", "./calculator_recursion/api.c", "./assembly_parser/inst.h", "./assembly_parser/inst.c", "./assembly_parser/analyze.h", "./assembly_parser/analyze.c", "./assembly_parser/trace.h", "./assembly_parser/object.h", "./assembly_parser/object.c", "./assembly_parser/execute.h", "./assembly_parser/execute.c"
 
 # output path
 $OutputPath = "./out/app.exe"